@@ -151,6 +151,29 @@ $(CHS_ROOT)/target/sim/models/24FC1025.v: $(CHS_ROOT)/Bender.yml | $(CHS_ROOT)/t
 	unzip -p 24xx1025_Verilog_Model.zip 24FC1025.v > $@
 	rm 24xx1025_Verilog_Model.zip
 
+# Boot latency benchmark: boot an image in each autonomous boot mode the testbench supports
+# and report per-stage latencies from the dumped boot traces. Needs a compiled design.
+CHS_SIM_BOOTBENCH_MODES ?= 2 3
+CHS_SIM_BOOTBENCH_IMAGE ?= $(CHS_SW_DIR)/tests/helloworld.gpt.memh
+
+CHS_SIM_BOOTBENCH_TAG   ?=
+
+chs-sim-bootbench: $(CHS_SIM_BOOTBENCH_IMAGE)
+	cd $(CHS_ROOT)/target/sim/vsim && for mode in $(CHS_SIM_BOOTBENCH_MODES); do \
+		$(VSIM) -c -do "set BOOTMODE $$mode; set IMAGE $(CHS_SIM_BOOTBENCH_IMAGE); source start.cheshire_soc.tcl; run -all; quit" > bootbench$(CHS_SIM_BOOTBENCH_TAG).$$mode.log; \
+	done
+	$(CHS_ROOT)/util/boot_bench.py $(foreach mode,$(CHS_SIM_BOOTBENCH_MODES),$(CHS_ROOT)/target/sim/vsim/bootbench$(CHS_SIM_BOOTBENCH_TAG).$(mode).log)
+
+# Compare boot latency with the boot ROM's hot code run from ROM and from SPM. This rebuilds
+# the software stack, boot ROM, and design for each layout, so it needs the boot ROM toolchain.
+chs-sim-bootbench-brom:
+	@test -x $(CHS_SW_CC) || (echo "chs-sim-bootbench-brom: boot ROM toolchain not found" >&2; exit 1)
+	for hot in 0 1; do \
+		$(MAKE) -B CHS_BROM_HOT_SPM=$$hot $(CHS_SW_LIBS) $(CHS_ROOT)/hw/bootrom/cheshire_bootrom.sv $(CHS_SIM_BOOTBENCH_IMAGE) && \
+		(cd $(CHS_ROOT)/target/sim/vsim && $(VSIM) -c -do "source compile.cheshire_soc.tcl; quit") && \
+		$(MAKE) CHS_BROM_HOT_SPM=$$hot CHS_SIM_BOOTBENCH_TAG=.hot$$hot chs-sim-bootbench || exit 1; \
+	done
+
 CHS_SIM_ALL += $(CHS_ROOT)/target/sim/models/s25fs512s.v
 CHS_SIM_ALL += $(CHS_ROOT)/target/sim/models/24FC1025.v
 CHS_SIM_ALL += $(CHS_ROOT)/target/sim/vsim/compile.cheshire_soc.tcl
@@ -165,7 +188,7 @@ include target/xilinx/xilinx.mk
 # Phonies (KEEP AT END OF FILE) #
 #################################
 
-.PHONY: chs-all chs-nonfree-init chs-clean-deps chs-sw-all chs-hw-all chs-bootrom-all chs-sim-all chs-xilinx-all
+.PHONY: chs-all chs-nonfree-init chs-clean-deps chs-sw-all chs-hw-all chs-bootrom-all chs-sim-all chs-sim-bootbench chs-sim-bootbench-brom chs-xilinx-all
 
 CHS_ALL += $(CHS_SW_ALL) $(CHS_HW_ALL) $(CHS_SIM_ALL)
 
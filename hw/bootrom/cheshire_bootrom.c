@@ -18,6 +18,20 @@
 #include "hal/spi_sdcard.h"
 #include "hal/uart_debug.h"
 #include "gpt.h"
+#include "blkcache.h"
+#include "boottrace.h"
+
+// The block cache must end before the boot trace (see `params.h`)
+_Static_assert(sizeof(blkcache_t) <= 0x2080, "Block cache overlaps the boot trace");
+
+// Boot from a GPT disk (or raw code) through a block cache the ZSL inherits with the device
+int boot_gpt_cached(gpt_read_t read, void *priv) {
+    boottrace_mark(BOOTTRACE_ROM_DEVICE);
+    blkcache_t *cache = (blkcache_t *)__BOOT_CACHE;
+    blkcache_init(cache, read, priv);
+    return gpt_boot_part_else_raw(blkcache_read, cache, &__base_spm, __BOOT_SPM_MAX_LBAS,
+                                  __BOOT_ZSL_TYPE_GUID, 0);
+}
 
 extern int boot_next_stage(void *);
 
@@ -28,7 +42,7 @@ int boot_passive(uint64_t core_freq) {
     volatile uint32_t *scratch = reg32(&__base_regs, CHESHIRE_SCRATCH_0_REG_OFFSET);
     // While we poll bit 2 of scratch[2], check for incoming UART debug requests
     while (!(scratch[2] & 2))
-        if (uart_debug_check(&__base_uart)) return uart_debug_serve(&__base_uart);
+        if (uart_debug_check(&__base_uart)) return uart_debug_serve(&__base_uart, core_freq);
     // No UART (or JTAG) requests came in, but scratch[2][2] was set --> run code at scratch[1:0]
     scratch[2] = 0;
     return boot_next_stage((void *)(uintptr_t)(((uint64_t)scratch[1] << 32) | scratch[0]));
@@ -37,43 +51,55 @@ int boot_passive(uint64_t core_freq) {
 int boot_spi_sdcard(uint64_t core_freq, uint64_t rtc_freq) {
     // Initialize device handle
     spi_sdcard_t device = {
-        .spi_freq = 24 * 1000 * 1000, // 24MHz (maximum is 25MHz)
+        .spi_freq = MIN(50 * 1000 * 1000, core_freq / 2), // 50MHz if high-speed, else 25MHz
         .csid = 0,
         .csid_dummy = SPI_HOST_PARAM_NUM_C_S - 1 // Last physical CS is designated dummy
     };
     CHECK_CALL(spi_sdcard_init(&device, core_freq))
-    // Wait for device to be initialized (1ms, round up extra tick to be sure)
+    // Wait for device to be initialized (1ms, round up extra tick to be sure). This deadline
+    // is relative to reset, so it overlaps with the LLC BIST, calibration, and init above.
     clint_spin_until((1000 * rtc_freq) / (1000 * 1000) + 1);
-    return gpt_boot_part_else_raw(spi_sdcard_read_checkcrc, &device, &__base_spm,
-                                  __BOOT_SPM_MAX_LBAS, __BOOT_ZSL_TYPE_GUID, 0);
+    return boot_gpt_cached(spi_sdcard_read_checkcrc, &device);
 }
 
 int boot_spi_s25fs512s(uint64_t core_freq, uint64_t rtc_freq) {
-    // Initialize device handle
+    // Initialize device handle; quad reads support up to 100MHz with default latency
     spi_s25fs512s_t device = {
-        .spi_freq = MIN(40 * 1000 * 1000, core_freq / 4), // Up to quarter core freq or 40MHz
+        .spi_freq = MIN((__BOOT_SPI_NOR_QUAD ? 100 : 40) * 1000 * 1000, core_freq / 4),
         .csid = 1};
     CHECK_CALL(spi_s25fs512s_init(&device, core_freq))
-    // Wait for device to be initialized (t_PU = 300us, round up extra tick to be sure)
+    // Wait for device to be initialized (t_PU = 300us, round up extra tick to be sure). As for
+    // SD cards, this deadline is relative to reset and overlaps with the steps before.
     clint_spin_until((350 * rtc_freq) / (1000 * 1000) + 1);
-    return gpt_boot_part_else_raw(spi_s25fs512s_single_read, &device, &__base_spm,
-                                  __BOOT_SPM_MAX_LBAS, __BOOT_ZSL_TYPE_GUID, 0);
+    // Enable quad I/O with the default latency code of 8 dummy cycles, valid at all clocks
+    if (__BOOT_SPI_NOR_QUAD) CHECK_CALL(spi_s25fs512s_setup_quad(&device, 8))
+    // Stream each read as one flash command
+    return boot_gpt_cached(spi_s25fs512s_stream_read, &device);
 }
 
 int boot_i2c_24fc1025(uint64_t core_freq) {
     // Initialize device handle
     dif_i2c_t i2c;
-    CHECK_CALL(i2c_24fc1025_init(&i2c, core_freq))
-    return gpt_boot_part_else_raw(i2c_24fc1025_read, &i2c, &__base_spm, __BOOT_SPM_MAX_LBAS,
-                                  __BOOT_ZSL_TYPE_GUID, 0);
+    CHECK_CALL(i2c_24fc1025_init(&i2c, core_freq, __BOOT_I2C_FAST_PLUS))
+    return boot_gpt_cached(i2c_24fc1025_stream_read, &i2c);
 }
 
-int main() {
+// `_start` passes the calibration start point captured before the LLC BIST to `main`
+#pragma GCC diagnostic ignored "-Wmain"
+int main(uint64_t cal_mcycle, uint64_t cal_mtime) {
+    boottrace_reset();
+    boottrace_mark(BOOTTRACE_ROM_ENTRY);
     // Read boot mode and reference frequency
     uint32_t bootmode = *reg32(&__base_regs, CHESHIRE_BOOT_MODE_REG_OFFSET);
     uint32_t rtc_freq = *reg32(&__base_regs, CHESHIRE_RTC_FREQ_REG_OFFSET);
-    // Compute the boot core frequency using the reference clock
-    uint64_t core_freq = clint_get_core_freq(rtc_freq, 2500);
+    // Finish computing the boot core frequency started before the LLC BIST; hand it off.
+    // Should this yield an implausible value, measure again from scratch.
+    uint64_t core_freq = clint_get_core_freq_from(rtc_freq, 2500, cal_mcycle, cal_mtime);
+    if (clint_set_core_freq_handoff(core_freq)) {
+        core_freq = clint_get_core_freq(rtc_freq, 2500);
+        clint_set_core_freq_handoff(core_freq);
+    }
+    boottrace_mark(BOOTTRACE_ROM_FREQ);
     // In case of reentry, store return in scratch0 as is convention
     switch (bootmode) {
     case 0:
@@ -13,6 +13,9 @@
 #include "dif/clint.h"
 #include "gpt.h"
 #include "dif/uart.h"
+#include "dif/dma.h"
+#include "boottrace.h"
+#include "crc32.h"
 #include "printf.h"
 
 // Type for firmware payload
@@ -30,18 +33,118 @@ static inline int grread(void *priv, void *buf, uint64_t addr, uint64_t len) {
     return ret;
 }
 
-static inline void load_part_or_spin(void *priv, const uint64_t *pguid, void *const dst,
-                                     const char *name, uint64_t max_lbas) {
+// Space for the (decompressed) device tree; the firmware may extend up to the device tree
+#define ZSL_DTB_MAX_BYTES 0x100000
+
+// Staging buffers in SPM: the device reads into one while the DMA copies the other to DRAM
+#define ZSL_STAGE_BYTES 0x1000
+static uint8_t stage[2][ZSL_STAGE_BYTES] __attribute__((aligned(64)));
+
+// Copy from the device to DRAM through the staging buffers, optionally computing a CRC32
+// of the data while the DMA copies it out.
+static inline int staged_read(void *priv, void *dst, uint64_t addr, uint64_t len, uint32_t *crc) {
+    uint64_t tf_id[2] = {0, 0}, last = 0;
+    uint32_t state = -1;
+    for (uint64_t offs = 0, i = 0; offs < len; offs += ZSL_STAGE_BYTES, i ^= 1) {
+        uint64_t num = MIN(ZSL_STAGE_BYTES, len - offs);
+        // Wait until the buffer's previous copy is done before refilling it
+        while (*(sys_dma_done_ptr()) < tf_id[i]) asm volatile("nop");
+        CHECK_CALL(grread(priv, stage[i], addr + offs, num))
+        fence();
+        tf_id[i] = last = sys_dma_memcpy((uintptr_t)dst + offs, (uintptr_t)stage[i], num);
+        if (crc) state = crc32_update(state, stage[i], num);
+    }
+    // Wait for the last copies to complete
+    while (*(sys_dma_done_ptr()) < last) asm volatile("nop");
+    if (crc) *crc = ~state;
+    return 0;
+}
+
+// Decode an LZ4 block. The source may lie at the end of the destination, as long as it ends
+// at least `ZSL_LZ4_MARGIN` past the decoded output so the output never overtakes it.
+#define ZSL_LZ4_MARGIN(len) (((len) >> 8) + 32)
+
+static inline int lz4_decode(uint8_t *dst, uint64_t out_len, const uint8_t *src, uint64_t len) {
+    const uint8_t *const src_end = src + len;
+    uint8_t *const dst_end = dst + out_len;
+    uint8_t *d = dst;
+    while (1) {
+        CHECK_ASSERT(0x11, src < src_end)
+        uint64_t tok = *src++, num = tok >> 4;
+        // Copy literals
+        if (num == 15) do {
+                CHECK_ASSERT(0x11, src < src_end)
+                num += *src;
+            } while (*src++ == 255);
+        CHECK_ASSERT(0x12, num <= (uint64_t)(src_end - src) && num <= (uint64_t)(dst_end - d))
+        if (src >= d + num || d >= src + num) __builtin_memcpy(d, src, num);
+        else for (uint64_t i = 0; i < num; ++i) d[i] = src[i];
+        src += num;
+        d += num;
+        // The last sequence holds only literals
+        if (src == src_end) break;
+        // Copy match from output, which may overlap the copied bytes
+        CHECK_ASSERT(0x13, src_end - src >= 2)
+        uint64_t offs = src[0] | (src[1] << 8);
+        src += 2;
+        num = tok & 15;
+        if (num == 15) do {
+                CHECK_ASSERT(0x14, src < src_end)
+                num += *src;
+            } while (*src++ == 255);
+        num += 4;
+        CHECK_ASSERT(0x15, offs && offs <= (uint64_t)(d - dst) && num <= (uint64_t)(dst_end - d))
+        if (offs >= num) __builtin_memcpy(d, d - offs, num);
+        else for (uint64_t i = 0; i < num; ++i) d[i] = d[i - offs];
+        d += num;
+    }
+    CHECK_ASSERT(0x16, d == dst_end)
+    return 0;
+}
+
+// Load a partition to `dst`. If it has a payload header, only the payload is read and its CRC32
+// is checked. LZ4 payloads are read to the end of the output window, then decompressed in place.
+static inline int load_part(void *priv, uint8_t *dst, uint64_t lba_begin, uint64_t lba_end,
+                            uint64_t max_len) {
+    uint64_t addr = 0x200 * lba_begin, len = 0x200 * (lba_end - lba_begin + 1);
+    gpt_payload_t pl;
+    CHECK_CALL(grread(priv, &pl, addr, sizeof(pl)))
+    if (pl.magic != GPT_PAYLOAD_MAGIC) return staged_read(priv, dst, addr, len, 0);
+    CHECK_ASSERT(0x11, pl.len <= len - 0x200)
+    uint64_t src_offs = 0;
+    if (pl.flags & GPT_PAYLOAD_LZ4) {
+        uint64_t end = pl.out_len + ZSL_LZ4_MARGIN(pl.len);
+        src_offs = end > pl.len ? (end - pl.len + 63) & ~63UL : 0;
+    }
+    CHECK_ASSERT(0x12, src_offs + pl.len <= max_len)
+    uint32_t crc;
+    CHECK_CALL(staged_read(priv, dst + src_offs, addr + 0x200, pl.len, __BOOT_ZSL_CRC ? &crc : 0))
+    CHECK_ASSERT(0x17, !__BOOT_ZSL_CRC || crc == pl.crc)
+    if (!(pl.flags & GPT_PAYLOAD_LZ4)) return 0;
+    printf("inflate %d B to %d B... ", pl.len, pl.out_len);
+    return lz4_decode(dst, pl.out_len, dst + src_offs, pl.len);
+}
+
+static inline void load_part_or_spin(void *priv, const gpt_header_t *hdr, const uint64_t *pguid,
+                                     void *const dst, const char *name, uint64_t max_lbas,
+                                     uint64_t max_len) {
     uint64_t lba_begin, lba_end;
     int64_t part_idx = -1;
-    if (gpt_find_partition(grread, priv, &part_idx, &lba_begin, &lba_end, max_lbas, pguid, 0))
+    if (!hdr)
+        printf("[ZSL] Error reading GPT header for %s", name);
+    else if (gpt_find_partition(grread, priv, hdr, &part_idx, &lba_begin, &lba_end, max_lbas,
+                                pguid, 0))
         printf("[ZSL] Error finding %s", name);
     else if (part_idx < 0)
         printf("[ZSL] No %s", name);
     else {
         printf("[ZSL] Copy %s (part %d, LBA %d-%d) to 0x%lx... ", name, part_idx, lba_begin,
                lba_end, dst);
-        grread(priv, dst, 0x200 * lba_begin, 0x200 * (lba_end - lba_begin + 1));
+        int ret = load_part(priv, dst, lba_begin, lba_end, max_len);
+        if (ret) {
+            printf("failed (0x%x)\r\n", ret);
+            while (1) wfi();
+        }
         printf("OK\r\n");
         return;
     }
@@ -50,11 +153,24 @@ static inline void load_part_or_spin(void *priv, const uint64_t *pguid, void *co
     while (1) wfi();
 }
 
+// Print the boot-stage trace, timing each stage from boot ROM entry
+static inline void print_trace(uint32_t rtc_freq) {
+    boottrace_t *trace = (boottrace_t *)__BOOT_TRACE;
+    if (trace->magic != BOOTTRACE_MAGIC || !trace->count) return;
+    printf("[ZSL] Boot trace (stage: mcycle, us):\r\n");
+    for (uint32_t i = 0; i < trace->count; ++i) {
+        boottrace_rec_t *rec = &trace->recs[i];
+        uint64_t us = (rec->mtime - trace->recs[0].mtime) * 1000 * 1000 / rtc_freq;
+        printf("[ZSL]   %d: %lu, %lu\r\n", rec->stage, rec->mcycle, us);
+    }
+}
+
 int main(void) {
+    boottrace_mark(BOOTTRACE_ZSL_ENTRY);
     // Get system parameters
     uint32_t bootmode = *reg32(&__base_regs, CHESHIRE_BOOT_MODE_REG_OFFSET);
     uint32_t rtc_freq = *reg32(&__base_regs, CHESHIRE_RTC_FREQ_REG_OFFSET);
-    uint64_t core_freq = clint_get_core_freq(rtc_freq, 2500);
+    uint64_t core_freq = clint_get_core_freq_handoff(rtc_freq, 2500);
     rgp = (void *)(uintptr_t)*reg32(&__base_regs, CHESHIRE_SCRATCH_3_REG_OFFSET);
     uint32_t read = *reg32(&__base_regs, CHESHIRE_SCRATCH_0_REG_OFFSET);
     void *priv = (void *)(uintptr_t)*reg32(&__base_regs, CHESHIRE_SCRATCH_1_REG_OFFSET);
@@ -76,11 +192,20 @@ int main(void) {
     // If this is a GPT disk boot, load payload and device tree
     if (read & 1) {
         rread = (gpt_read_t)(void *)(uintptr_t)(read & ~1);
-        load_part_or_spin(priv, __BOOT_DTB_TYPE_GUID, __BOOT_ZSL_DTB, "device tree", 64);
-        load_part_or_spin(priv, __BOOT_FW_TYPE_GUID, __BOOT_ZSL_FW, "firmware", 8192);
+        // Read the GPT header only once for both lookups
+        gpt_header_t hdr;
+        gpt_header_t *phdr = gpt_read_header(grread, priv, &hdr) ? 0 : &hdr;
+        load_part_or_spin(priv, phdr, __BOOT_DTB_TYPE_GUID, __BOOT_ZSL_DTB, "device tree", 64,
+                          ZSL_DTB_MAX_BYTES);
+        boottrace_mark(BOOTTRACE_ZSL_DTB);
+        load_part_or_spin(priv, phdr, __BOOT_FW_TYPE_GUID, __BOOT_ZSL_FW, "firmware", 8192,
+                          (uintptr_t)__BOOT_ZSL_DTB - (uintptr_t)__BOOT_ZSL_FW);
+        boottrace_mark(BOOTTRACE_ZSL_FW);
     }
 
     // Launch payload
+    boottrace_mark(BOOTTRACE_ZSL_LAUNCH);
+    print_trace(rtc_freq);
     payload_t fw = __BOOT_ZSL_FW;
     printf("[ZSL] Launch firmware at %lx with device tree at %lx\r\n", fw, __BOOT_ZSL_DTB);
     fencei();
@@ -0,0 +1,30 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A small LRU block cache wrapping any `gpt_read_t` device read. On a miss, it fetches the
+// entire surrounding block, reading ahead of the requested bytes. Reads covering whole
+// aligned blocks bypass the cache. The cache state is self-contained so it can be placed
+// in a fixed memory region and shared across boot stages.
+
+#pragma once
+
+#include <stdint.h>
+#include "gpt.h"
+
+#define BLKCACHE_BLOCK_SIZE (4 * 0x200)
+#define BLKCACHE_BLOCKS 4
+
+typedef struct {
+    gpt_read_t read;                                    // Underlying device read
+    void *priv;                                         // Underlying device handle
+    uint64_t tick;                                      // Access counter for LRU
+    uint64_t tag[BLKCACHE_BLOCKS];                      // Block address plus one; 0 is invalid
+    uint64_t used[BLKCACHE_BLOCKS];                     // Tick of last use of each block
+    uint8_t data[BLKCACHE_BLOCKS][BLKCACHE_BLOCK_SIZE]; // Cached data
+} blkcache_t;
+
+void blkcache_init(blkcache_t *cache, gpt_read_t read, void *priv);
+
+// Implements `gpt_read_t`; the private pointer passed is an initialized cache
+int blkcache_read(void *priv, void *buf, uint64_t addr, uint64_t len);
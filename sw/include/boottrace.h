@@ -0,0 +1,44 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// A boot-stage timestamp trace in a fixed SPM region (`__BOOT_TRACE`). Each boot stage
+// appends records of its progress; the ZSL prints them and the testbench dumps them.
+
+#pragma once
+
+#include <stdint.h>
+
+#define BOOTTRACE_MAGIC 0x43525442 /*BTRC*/
+#define BOOTTRACE_MAX_RECS 20
+
+// Stage IDs; also decoded by the testbench and `util/boot_bench.py`
+enum boottrace_stage {
+    BOOTTRACE_ROM_ENTRY = 1,  // Boot ROM entered `main`
+    BOOTTRACE_ROM_FREQ = 2,   // Boot ROM calibrated core frequency
+    BOOTTRACE_ROM_DEVICE = 3, // Boot ROM initialized boot device
+    BOOTTRACE_ROM_LOADED = 4, // Boot ROM loaded next stage to SPM
+    BOOTTRACE_ZSL_ENTRY = 5,  // ZSL entered `main`
+    BOOTTRACE_ZSL_DTB = 6,    // ZSL loaded device tree
+    BOOTTRACE_ZSL_FW = 7,     // ZSL loaded firmware
+    BOOTTRACE_ZSL_LAUNCH = 8  // ZSL launches firmware
+};
+
+typedef struct {
+    uint32_t stage;
+    uint32_t reserved;
+    uint64_t mcycle;
+    uint64_t mtime;
+} boottrace_rec_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    boottrace_rec_t recs[BOOTTRACE_MAX_RECS];
+} boottrace_t;
+
+// Clear the trace; called once by the boot ROM
+void boottrace_reset();
+
+// Append a record unless the trace is invalid or full
+void boottrace_mark(enum boottrace_stage stage);
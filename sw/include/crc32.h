@@ -0,0 +1,12 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// CRC32 (IEEE 802.3) using a nibble-wise lookup table to save ROM space. Start with a state
+// of `-1`, update it with any number of `crc32_update` calls, and invert it for the CRC.
+
+#pragma once
+
+#include <stdint.h>
+
+uint32_t crc32_update(uint32_t crc, const void *data, uint64_t len);
@@ -19,6 +19,17 @@ void clint_spin_ticks(uint64_t ticks);
 // This assumes a stable clock; ref_time_inv is the measurement period's *inverse*
 uint64_t clint_get_core_freq(uint64_t ref_freq, uint64_t ref_time_inv);
 
+// Like `clint_get_core_freq`, but starting from an RTC tick rollover captured earlier
+uint64_t clint_get_core_freq_from(uint64_t ref_freq, uint64_t ref_time_inv,
+                                  uint64_t start_mcycle, uint64_t start_mtime);
+
+// Hand off the calibrated core frequency to later boot stages and programs. Returns nonzero
+// and clears the handoff if the frequency is implausible (see `params.h`).
+int clint_set_core_freq_handoff(uint64_t core_freq);
+
+// Get the handed-off core frequency; if there is none, measure it and hand it off
+uint64_t clint_get_core_freq_handoff(uint64_t ref_freq, uint64_t ref_time_inv);
+
 void clint_set_mtimecmpx(uint64_t timer_idx, uint64_t value);
 
 // PRE: requires an appropriate trap handler catching the timer interrupt
@@ -14,12 +14,39 @@ extern int boot_next_stage(void *);
 
 typedef int (*gpt_read_t)(void *priv, void *buf, uint64_t addr, uint64_t len);
 
+// Partition entry array info from the GPT header; read once and reuse for lookups
+typedef struct __attribute__((packed)) {
+    uint64_t lba;   // First LBA of the partition entry array
+    uint32_t count; // Number of partition entries
+    uint32_t size;  // Size of each partition entry
+} gpt_header_t;
+
+// The type-specific partition attribute bits may hold the payload size in LBAs. If nonzero,
+// lookups treat the partition as ending after its payload, so only the payload is read.
+#define GPT_ATTR_PAYLOAD_LBAS_SHIFT 48
+
+// Optional header in the first sector of a loaded partition, describing its payload in the
+// following sectors. Created by `util/gen_zslpart.py`.
+#define GPT_PAYLOAD_MAGIC 0x0054524150534843UL /*CHSPART*/
+#define GPT_PAYLOAD_LZ4 (1 << 0)
+
+typedef struct __attribute__((packed)) {
+    uint64_t magic;
+    uint64_t flags;
+    uint64_t len;     // Payload bytes stored in the partition
+    uint64_t out_len; // Payload bytes once decompressed
+    uint64_t crc;     // CRC32 of the stored payload bytes
+} gpt_payload_t;
+
+// Fails if the signature does not match or the entry array is not parseable
+int gpt_read_header(gpt_read_t read, void *priv, gpt_header_t *hdr);
+
 int gpt_check_signature(gpt_read_t read, void *priv);
 
 // Either the partition type or identity must match
-int gpt_find_partition(gpt_read_t read, void *priv, int64_t *part_idx, uint64_t *lba_begin,
-                       uint64_t *lba_end, uint64_t max_lbas, const uint64_t *tguid,
-                       const uint64_t *pguid);
+int gpt_find_partition(gpt_read_t read, void *priv, const gpt_header_t *hdr, int64_t *part_idx,
+                       uint64_t *lba_begin, uint64_t *lba_end, uint64_t max_lbas,
+                       const uint64_t *tguid, const uint64_t *pguid);
 
 int gpt_boot_part_else_raw(gpt_read_t read, void *priv, void *code_buf, uint64_t max_lbas,
                            const uint64_t *tguid, const uint64_t *pguid);
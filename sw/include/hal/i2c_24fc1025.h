@@ -12,8 +12,13 @@
 #include "sw/device/lib/dif/dif_i2c.h"
 
 // Sets up only this device; other functions may be used with own setup if requirements are met.
-int i2c_24fc1025_init(dif_i2c_t *i2c, uint64_t core_freq);
+// Fast-mode Plus (1 MHz) requires all devices on the bus to support it (24FC1025: VCC >= 2.5V).
+int i2c_24fc1025_init(dif_i2c_t *i2c, uint64_t core_freq, int fast_plus);
 
 int i2c_24fc1025_read(void *priv, void *buf, uint64_t addr, uint64_t len);
 
+// Reads sequentially using one read command per 64 KiB block, draining the RX FIFO at a watermark
+int i2c_24fc1025_stream_read(void *priv, void *buf, uint64_t addr, uint64_t len);
+
+// Writes in 128B pages, acknowledge-polling for each page's write cycle to complete
 int i2c_24fc1025_write(void *priv, void *buf, uint64_t addr, uint64_t len);
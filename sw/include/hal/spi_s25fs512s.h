@@ -11,11 +11,18 @@
 #include <stdint.h>
 #include "sw/device/lib/dif/dif_spi_host.h"
 
+// Uniform erase sector and program page sizes; require CR3V[3] (uniform sectors) and CR3V[4]
+// (512B page buffer), which `spi_s25fs512s_flash` checks
+#define SPI_S25FS512S_SECTOR_SIZE (256 * 1024)
+#define SPI_S25FS512S_PAGE_SIZE 512
+
 // Handle identifying relevant configuration of the device; *considered constant after init*.
 typedef struct {
     dif_spi_host_t spi_host; // Will be set by init
     uint64_t spi_freq;       // Should be set before init
     int csid;                // Should be set before init
+    int quad;                // Will be set by quad setup
+    uint8_t latency;         // Will be set by quad setup
 } spi_s25fs512s_t;
 
 // Sets up only this device; other functions may be used with own setup if requirements are met.
@@ -24,5 +31,21 @@ int spi_s25fs512s_init(spi_s25fs512s_t *handle, uint64_t core_freq);
 
 int spi_s25fs512s_single_read(void *priv, void *buf, uint64_t addr, uint64_t len);
 
+// Enables quad I/O in CR1V and sets the read latency code (dummy cycles) in CR2V.
+// Like all other commands, this must be issued after the power-up period.
+int spi_s25fs512s_setup_quad(spi_s25fs512s_t *handle, uint8_t latency);
+
+// Quad I/O read (0xEC) with non-continuous mode bits; requires quad setup
+int spi_s25fs512s_quad_read(void *priv, void *buf, uint64_t addr, uint64_t len);
+
+// Reads using one command, keeping CS asserted across FIFO-sized chunks (quad if set up)
+int spi_s25fs512s_stream_read(void *priv, void *buf, uint64_t addr, uint64_t len);
+
 // Flashing is done as whole 512B pages
 int spi_s25fs512s_single_flash(void *priv, void *buf, uint64_t page, uint64_t num_pages);
+
+// Flashes data starting at a sector boundary. Sectors are erased only if needed, and only
+// changed (or after an erase, non-blank) pages are programmed, using quad data if set up.
+// If the last sector must be erased, its bytes beyond len are left blank. Fails unless the
+// device is configured for uniform sectors and a 512B page buffer (see above).
+int spi_s25fs512s_flash(void *priv, void *buf, uint64_t addr, uint64_t len);
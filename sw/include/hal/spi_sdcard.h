@@ -14,7 +14,7 @@
 // Handle identifying relevant configuration of the device; *considered constant after init*.
 typedef struct {
     dif_spi_host_t spi_host; // Will be set by init
-    uint64_t spi_freq;       // Should be set before init
+    uint64_t spi_freq;       // Should be set before init; above 25MHz needs high-speed mode
     int csid;                // Should be set before init
     int csid_dummy;          // Should be set before init
 } spi_sdcard_t;
@@ -30,8 +30,13 @@ static const uint64_t __spi_sdcard_data_timeout = 10000;
 
 // Sets up only this device; other functions may be used with own setup if requirements are met.
 // This assumes the power-up period of 1ms will be elapsed *before* issuing further commands.
+// If `spi_freq` exceeds 25MHz, the card is switched to high-speed mode (up to 50MHz) if its
+// CSD and SCR indicate CMD6 support; otherwise, the clock is limited to 25MHz.
 int spi_sdcard_init(spi_sdcard_t *handle, uint64_t core_freq);
 
 int spi_sdcard_read_checkcrc(void *priv, void *buf, uint64_t addr, uint64_t len);
 
 int spi_sdcard_read_ignorecrc(void *priv, void *buf, uint64_t addr, uint64_t len);
+
+// Compute the CRC16 of a data block as sent by the card (i.e. byte-swapped to big endian)
+uint16_t spi_sdcard_crc16(const void *data, uint64_t len);
@@ -13,4 +13,4 @@ int uart_debug_init(void *uart_base, uint64_t core_freq);
 // Check if we received a debug request (ACK byte on RX)
 int uart_debug_check(void *uart_base);
 
-int uart_debug_serve(void *uart_base);
+int uart_debug_serve(void *uart_base, uint64_t core_freq);
@@ -33,13 +33,36 @@ extern void *__base_dram;
 // Default boot baudrate
 static const uint32_t __BOOT_BAUDRATE = 115200;
 
+// Scratch register through which the boot ROM hands off the calibrated core frequency (Hz)
+static const uint32_t __BOOT_CORE_FREQ_SCRATCH = 6;
+
+// Range of plausible core frequencies (Hz); others are not handed off
+static const uint64_t __BOOT_CORE_FREQ_MIN = 1000 * 1000;
+static const uint64_t __BOOT_CORE_FREQ_MAX = 4000UL * 1000 * 1000;
+
+// Whether to boot from NOR flash using quad I/O reads
+static const int __BOOT_SPI_NOR_QUAD = 1;
+
+// Whether to boot from I2C EEPROM using Fast-mode Plus (1 MHz)
+static const int __BOOT_I2C_FAST_PLUS = 1;
+
 // Maximum number of LBAs to copy to SPM for boot (48 KiB)
 static const uint64_t __BOOT_SPM_MAX_LBAS = 2 * 48;
 
+// Location of the block cache shared by boot ROM and ZSL: in SPM, right after the ZSL
+static void *const __BOOT_CACHE = (void *)(0x10000000 + 0x200 * __BOOT_SPM_MAX_LBAS);
+
+// Location of the boot-stage trace: in SPM, after the block cache (at most 0x2080 bytes). It is
+// followed by the boot ROM's hot code and data at 0x1000E280 (see `cheshire_bootrom.ld`).
+static void *const __BOOT_TRACE = (void *)(0x10000000 + 0x200 * __BOOT_SPM_MAX_LBAS + 0x2080);
+
 // Locations for payload and device tree
 static void *const __BOOT_ZSL_DTB = (void *)0x80800000;
 static void *const __BOOT_ZSL_FW = (void *)0x80000000;
 
+// Whether the ZSL checks the CRC32 of partition payloads against their header while copying them
+static const int __BOOT_ZSL_CRC = 1;
+
 // GUID of zero-stage loader partition we boot from
 static const uint64_t __BOOT_ZSL_TYPE_GUID[2] = {0x4CE4FD950269B26AUL, 0x622C41011494CF98UL};
 
@@ -80,3 +80,13 @@ static inline void *gprw(void *gp) {
     if (!(cond)) return (ret);
 
 #define MIN(a, b) (((a) <= (b)) ? (a) : (b))
+
+// Marks hot boot code and the read-only data it looks up, which the boot ROM copies to and
+// accesses in SPM if built with `CHS_BROM_HOT_SPM`. Other programs link them as usual.
+#ifdef CHS_BROM_HOT_SPM
+#define BOOT_HOT __attribute__((section(".hot")))
+#define BOOT_HOT_DATA __attribute__((section(".hot.rodata")))
+#else
+#define BOOT_HOT
+#define BOOT_HOT_DATA
+#endif
@@ -0,0 +1,58 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "blkcache.h"
+#include "util.h"
+
+void blkcache_init(blkcache_t *cache, gpt_read_t read, void *priv) {
+    cache->read = read;
+    cache->priv = priv;
+    cache->tick = 0;
+    for (int i = 0; i < BLKCACHE_BLOCKS; ++i) cache->tag[i] = cache->used[i] = 0;
+}
+
+// Return the index of the cached block at `base`, fetching it into the LRU block on a miss.
+// Returns a negative value if the fetch failed.
+static inline int __blkcache_fetch(blkcache_t *cache, uint64_t base) {
+    int victim = 0;
+    for (int i = 0; i < BLKCACHE_BLOCKS; ++i) {
+        if (cache->tag[i] == base + 1) {
+            cache->used[i] = ++cache->tick;
+            return i;
+        }
+        if (cache->used[i] < cache->used[victim]) victim = i;
+    }
+    // Invalidate victim until the fetch succeeded
+    cache->tag[victim] = cache->used[victim] = 0;
+    if (cache->read(cache->priv, cache->data[victim], base, BLKCACHE_BLOCK_SIZE)) return -1;
+    cache->tag[victim] = base + 1;
+    cache->used[victim] = ++cache->tick;
+    return victim;
+}
+
+BOOT_HOT int blkcache_read(void *priv, void *buf, uint64_t addr, uint64_t len) {
+    // The private pointer passed is a cache
+    blkcache_t *cache = (blkcache_t *)priv;
+    uint8_t *dst = (uint8_t *)buf;
+    while (len) {
+        uint64_t offs = addr % BLKCACHE_BLOCK_SIZE;
+        uint64_t num;
+        if (offs == 0 && len >= BLKCACHE_BLOCK_SIZE) {
+            // Read whole blocks directly; this keeps bulk copies from thrashing the cache
+            num = len - len % BLKCACHE_BLOCK_SIZE;
+            CHECK_CALL(cache->read(cache->priv, dst, addr, num))
+        } else {
+            num = MIN(BLKCACHE_BLOCK_SIZE - offs, len);
+            int i = __blkcache_fetch(cache, addr - offs);
+            // If the block could not be fetched (e.g. at the device end), read only what we need
+            if (i < 0) CHECK_CALL(cache->read(cache->priv, dst, addr, num))
+            else __builtin_memcpy(dst, &cache->data[i][offs], num);
+        }
+        dst += num;
+        addr += num;
+        len -= num;
+    }
+    // Nothing went wrong
+    return 0;
+}
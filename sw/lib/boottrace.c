@@ -0,0 +1,23 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "boottrace.h"
+#include "dif/clint.h"
+#include "params.h"
+#include "util.h"
+
+void boottrace_reset() {
+    boottrace_t *trace = (boottrace_t *)__BOOT_TRACE;
+    trace->count = 0;
+    trace->magic = BOOTTRACE_MAGIC;
+}
+
+void boottrace_mark(enum boottrace_stage stage) {
+    boottrace_t *trace = (boottrace_t *)__BOOT_TRACE;
+    if (trace->magic != BOOTTRACE_MAGIC || trace->count >= BOOTTRACE_MAX_RECS) return;
+    boottrace_rec_t *rec = &trace->recs[trace->count++];
+    rec->stage = stage;
+    rec->mcycle = get_mcycle();
+    rec->mtime = clint_get_mtime();
+}
@@ -0,0 +1,19 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "crc32.h"
+
+static const uint32_t crc32_lut[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+uint32_t crc32_update(uint32_t crc, const void *data, uint64_t len) {
+    const uint8_t *bytes = data;
+    for (uint64_t i = 0; i < len; ++i) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ crc32_lut[crc & 0xF];
+        crc = (crc >> 4) ^ crc32_lut[crc & 0xF];
+    }
+    return crc;
+}
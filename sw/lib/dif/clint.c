@@ -8,12 +8,18 @@
 
 #include "dif/clint.h"
 #include "regs/clint.h"
+#include "regs/cheshire.h"
 #include "util.h"
 #include "params.h"
 
 uint64_t clint_get_mtime() {
-    return (((uint64_t)*reg32(&__base_clint, CLINT_MTIME_HIGH_REG_OFFSET)) << 32) |
-           ((uint64_t)*reg32(&__base_clint, CLINT_MTIME_LOW_REG_OFFSET));
+    uint32_t hi, lo;
+    // Retry if the high word changes while we read the low word
+    do {
+        hi = *reg32(&__base_clint, CLINT_MTIME_HIGH_REG_OFFSET);
+        lo = *reg32(&__base_clint, CLINT_MTIME_LOW_REG_OFFSET);
+    } while (hi != *reg32(&__base_clint, CLINT_MTIME_HIGH_REG_OFFSET));
+    return ((uint64_t)hi << 32) | lo;
 }
 
 void clint_spin_until(uint64_t tgt_mtime) {
@@ -25,24 +31,47 @@ void clint_spin_ticks(uint64_t ticks) {
     clint_spin_until(clint_get_mtime() + ticks);
 }
 
-uint64_t clint_get_core_freq(uint64_t ref_freq, uint64_t ref_time_inv) {
-    uint64_t end_mcycle, start_mcycle;
-    uint64_t num_ticks = ref_freq / ref_time_inv;
-    uint64_t end_mtime = clint_get_mtime(), start_mtime;
-    // Capture start times until we observe an RTC tick rollover
-    do {
-        start_mcycle = get_mcycle();
-        start_mtime = clint_get_mtime();
-    } while (start_mtime == end_mtime);
-    // Capture end times until we observe rollover to the past-the-end RTC tick
+uint64_t clint_get_core_freq_from(uint64_t ref_freq, uint64_t ref_time_inv,
+                                  uint64_t start_mcycle, uint64_t start_mtime) {
+    uint64_t end_mcycle, num_ticks = ref_freq / ref_time_inv;
+    uint64_t last_mtime = clint_get_mtime(), end_mtime;
+    // Capture end times until we observe a rollover to (or past) the past-the-end RTC tick.
+    // If the measurement period already elapsed, this still waits for the next rollover.
     do {
         end_mcycle = get_mcycle();
         end_mtime = clint_get_mtime();
-    } while (end_mtime < start_mtime + num_ticks);
+    } while (end_mtime == last_mtime || end_mtime < start_mtime + num_ticks);
     // Compute current frequency in Hz
     return ((end_mcycle - start_mcycle) * ref_freq) / (end_mtime - start_mtime);
 }
 
+uint64_t clint_get_core_freq(uint64_t ref_freq, uint64_t ref_time_inv) {
+    uint64_t start_mcycle, start_mtime, last_mtime = clint_get_mtime();
+    // Capture start times until we observe an RTC tick rollover
+    do {
+        start_mcycle = get_mcycle();
+        start_mtime = clint_get_mtime();
+    } while (start_mtime == last_mtime);
+    return clint_get_core_freq_from(ref_freq, ref_time_inv, start_mcycle, start_mtime);
+}
+
+int clint_set_core_freq_handoff(uint64_t core_freq) {
+    // Clear the handoff for implausible values so that later stages measure for themselves
+    int valid = (core_freq >= __BOOT_CORE_FREQ_MIN && core_freq <= __BOOT_CORE_FREQ_MAX);
+    *reg32(&__base_regs, CHESHIRE_SCRATCH_0_REG_OFFSET + 4 * __BOOT_CORE_FREQ_SCRATCH) =
+        valid ? core_freq : 0;
+    return !valid;
+}
+
+uint64_t clint_get_core_freq_handoff(uint64_t ref_freq, uint64_t ref_time_inv) {
+    uint64_t core_freq =
+        *reg32(&__base_regs, CHESHIRE_SCRATCH_0_REG_OFFSET + 4 * __BOOT_CORE_FREQ_SCRATCH);
+    if (core_freq) return core_freq;
+    core_freq = clint_get_core_freq(ref_freq, ref_time_inv);
+    clint_set_core_freq_handoff(core_freq);
+    return core_freq;
+}
+
 void clint_set_mtimecmpx(uint64_t timer_idx, uint64_t value) {
     uint32_t vlo = (uint32_t)(value);
     uint32_t vhi = (uint32_t)(value >> 32);
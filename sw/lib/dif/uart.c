@@ -10,7 +10,8 @@
 #include "params.h"
 
 void uart_init(void *uart_base, uint64_t freq, uint64_t baud) {
-    uint64_t divisor = freq / (baud << 4);
+    // Round divisor to nearest to minimize baud rate error at high rates
+    uint64_t divisor = (freq + (baud << 3)) / (baud << 4);
     uint8_t dlo = (uint8_t)(divisor);
     uint8_t dhi = (uint8_t)(divisor >> 8);
     *reg8(uart_base, UART_INTR_ENABLE_REG_OFFSET) = 0x00;   // Disable all interrupts
@@ -10,61 +10,70 @@
 #include "util.h"
 #include "regs/cheshire.h"
 #include "params.h"
+#include "boottrace.h"
+
+int gpt_read_header(gpt_read_t read, void *priv, gpt_header_t *hdr) {
+    // Signature is first 8 bytes of LBA1 (512B from disk start); entry array info is at 0x48
+    struct __attribute__((packed)) hdr_fields {
+        uint64_t sig;
+        uint8_t reserved[0x40];
+        gpt_header_t hdr;
+    } hf;
+    CHECK_CALL(read(priv, &hf, 0x200, sizeof(hf)))
+    CHECK_ASSERT(0x11, hf.sig == 0x5452415020494645UL /*EFI PART*/)
+    // We parse entries sector by sector, so they may not straddle sectors
+    CHECK_ASSERT(0x12, hf.hdr.size >= 0x38 && hf.hdr.size <= 0x200 && 0x200 % hf.hdr.size == 0)
+    *hdr = hf.hdr;
+    // Nothing went wrong
+    return 0;
+}
 
 int gpt_check_signature(gpt_read_t read, void *priv) {
-    // Signature is first 8 bytes of LBA1 (512B from disk start)
-    uint64_t sig;
-    // If call fails, we may as well report no signature was found
-    if (read(priv, &sig, 0x200, sizeof(sig))) return 0;
-    return (sig == 0x5452415020494645UL /*EFI PART*/);
+    // If reading the header fails, we may as well report no signature was found
+    gpt_header_t hdr;
+    return !gpt_read_header(read, priv, &hdr);
 }
 
-int gpt_find_partition(gpt_read_t read, void *priv, int64_t *part_idx, uint64_t *lba_begin,
-                       uint64_t *lba_end, uint64_t max_lbas, const uint64_t *tguid,
-                       const uint64_t *pguid) {
-    // Read partition-essential info from GPT header
-    struct __attribute__((packed)) hdr_fields {
-        uint64_t lba;
-        uint32_t count;
-        uint32_t size;
-    } hf;
-    uint64_t hf_offs = 0x200 + 0x48;
-    CHECK_CALL(read(priv, &hf, hf_offs, sizeof(hf)));
+int gpt_find_partition(gpt_read_t read, void *priv, const gpt_header_t *hdr, int64_t *part_idx,
+                       uint64_t *lba_begin, uint64_t *lba_end, uint64_t max_lbas,
+                       const uint64_t *tguid, const uint64_t *pguid) {
     // Find the first partition to fit in `max_lbas` and match the passed type or partition GUID.
     // If no such partition is found, the first partition (at most a `max_lbas` chunk) is booted.
     struct __attribute__((packed)) part_fields {
+        uint64_t tguid[2];
+        uint64_t pguid[2];
         uint64_t lba_begin;
         uint64_t lba_end;
-    } dim;
+        uint64_t attr;
+    } *pf = 0;
+    // Entry array is parsed one sector at a time
+    uint8_t sect[0x200] __attribute__((aligned(8)));
     int64_t p;
-    uint64_t guid[2];
-    for (p = 0; p < hf.count; ++p) {
-        // Read first two partition fields for size
-        uint64_t pe_offs = 0x200 * hf.lba + p * hf.size;
-        CHECK_CALL(read(priv, &dim, pe_offs + 0x20, sizeof(dim)));
+    for (p = 0; p < hdr->count; ++p) {
+        uint64_t pe_offs = 0x200 * hdr->lba + p * hdr->size;
+        if (pe_offs % 0x200 == 0) CHECK_CALL(read(priv, sect, pe_offs, sizeof(sect)))
+        pf = (struct part_fields *)&sect[pe_offs % 0x200];
+        // If the partition is stamped with its payload size, we only consider the payload
+        uint64_t payload_lbas = pf->attr >> GPT_ATTR_PAYLOAD_LBAS_SHIFT;
+        if (payload_lbas && payload_lbas <= pf->lba_end - pf->lba_begin)
+            pf->lba_end = pf->lba_begin + payload_lbas - 1;
         // Record first partition in any case (but only subset of bootable size)
         if (p == 0) {
-            *lba_begin = dim.lba_begin;
-            *lba_end = MIN(dim.lba_end, dim.lba_begin + max_lbas - 1);
+            *lba_begin = pf->lba_begin;
+            *lba_end = MIN(pf->lba_end, pf->lba_begin + max_lbas - 1);
         }
         // Skip if partition if it is too large to fit our criteria
-        if (dim.lba_end - dim.lba_begin >= max_lbas) continue;
-        // If it does fit in SPM, check our criteria, reading data as needed
-        if (tguid) {
-            CHECK_CALL(read(priv, &guid[0], pe_offs, sizeof(guid)))
-            if (guid[0] == tguid[0] && guid[1] == tguid[1]) break;
-        }
-        if (pguid) {
-            CHECK_CALL(read(priv, &guid[0], pe_offs + 0x10, sizeof(guid)))
-            if (guid[0] == pguid[0] && guid[1] == pguid[1]) break;
-        }
+        if (pf->lba_end - pf->lba_begin >= max_lbas) continue;
+        // If it does fit in SPM, check our criteria
+        if (tguid && pf->tguid[0] == tguid[0] && pf->tguid[1] == tguid[1]) break;
+        if (pguid && pf->pguid[0] == pguid[0] && pf->pguid[1] == pguid[1]) break;
     }
     // If we did find a viable partition after the first, write out LBA range
     *part_idx = -1;
-    if (p != hf.count) {
+    if (p != hdr->count) {
         *part_idx = p;
-        *lba_begin = dim.lba_begin;
-        *lba_end = dim.lba_end;
+        *lba_begin = pf->lba_begin;
+        *lba_end = pf->lba_end;
     }
     // Nothing went wrong
     return 0;
@@ -74,13 +83,15 @@ int gpt_boot_part_else_raw(gpt_read_t read, void *priv, void *code_buf, uint64_t
                            const uint64_t *tguid, const uint64_t *pguid) {
     uint64_t lba_begin = 0, lba_end = max_lbas - 1;
     int64_t part_idx;
-    if (gpt_check_signature(read, priv))
-        CHECK_CALL(
-            gpt_find_partition(read, priv, &part_idx, &lba_begin, &lba_end, max_lbas, tguid, pguid))
+    gpt_header_t hdr;
+    if (!gpt_read_header(read, priv, &hdr))
+        CHECK_CALL(gpt_find_partition(read, priv, &hdr, &part_idx, &lba_begin, &lba_end, max_lbas,
+                                      tguid, pguid))
     // Copy code to SPM (end is *inclusive*, not past-the-end)
     uint64_t addr = 0x200 * lba_begin;
     uint64_t len = 0x200 * (lba_end - lba_begin + 1);
     CHECK_CALL(read(priv, code_buf, addr, len));
+    boottrace_mark(BOOTTRACE_ROM_LOADED);
     // Write pointers for used read function to scratch registers for use in following stages
     *reg32(&__base_regs, CHESHIRE_SCRATCH_0_REG_OFFSET) = (uintptr_t)((void *)read) | 1;
     *reg32(&__base_regs, CHESHIRE_SCRATCH_1_REG_OFFSET) = (uintptr_t)priv;
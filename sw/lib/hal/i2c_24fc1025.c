@@ -13,7 +13,7 @@
 
 #include "dif/clint.h"
 
-int i2c_24fc1025_init(dif_i2c_t *i2c, uint64_t core_freq) {
+int i2c_24fc1025_init(dif_i2c_t *i2c, uint64_t core_freq, int fast_plus) {
     // Check for legal arguments
     CHECK_ASSERT(0x11, i2c != 0);
     CHECK_ASSERT(0x12, core_freq != 0);
@@ -26,7 +26,7 @@ int i2c_24fc1025_init(dif_i2c_t *i2c, uint64_t core_freq) {
     CHECK_CALL(dif_i2c_reset_fmt_fifo(i2c))
     CHECK_CALL(dif_i2c_reset_rx_fifo(i2c))
     CHECK_CALL(dif_i2c_reset_tx_fifo(i2c))
-    // Set up timing: worst case 24FC1025 @1.8V
+    // Set up timing: worst case 24FC1025 @1.8V, or @2.5V for Fast-mode Plus
     dif_i2c_timing_config_t timing_config = {
         .clock_period_nanos = (uint64_t)(1e9) / core_freq, // From system-side clock
         .lowest_target_device_speed = kDifI2cSpeedFast,    // Fast mode: up to 400 kBaud
@@ -34,6 +34,12 @@ int i2c_24fc1025_init(dif_i2c_t *i2c, uint64_t core_freq) {
         .sda_fall_nanos = 300,                             // From 24FC1025 datasheet
         .sda_rise_nanos = 100                              // From 24FC1025 datasheet
     };
+    if (fast_plus) {
+        timing_config.lowest_target_device_speed = kDifI2cSpeedFastPlus; // Up to 1 MBaud
+        timing_config.scl_period_nanos = 1000000 / 1000;                 // Max supported speed
+        timing_config.sda_fall_nanos = 120;                              // From I2C FM+ spec
+        timing_config.sda_rise_nanos = 120;                              // From I2C FM+ spec
+    }
     // Configure I2C
     dif_i2c_config_t config;
     CHECK_CALL(dif_i2c_compute_timing(timing_config, &config))
@@ -44,8 +50,14 @@ int i2c_24fc1025_init(dif_i2c_t *i2c, uint64_t core_freq) {
     return 0;
 }
 
-static inline int __i2c_24fc1025_access_chunk(dif_i2c_t *i2c, void *buf, uint64_t addr,
-                                              uint64_t len, int write) {
+// 0xA0 identifies an 24FC1025 on the bus, followed by block select B0 and chip selects A1, A0.
+// We overflow addresses to that device's upper 64 KiB block first, then further devices if any.
+static inline uint8_t __i2c_24fc1025_ctrl(uint64_t addr) {
+    return 0xA0 | ((addr >> 13) & 0x8) | ((addr >> 16) & 0x6);
+}
+
+static inline int __i2c_24fc1025_read_chunk(dif_i2c_t *i2c, void *buf, uint64_t addr,
+                                            uint64_t len) {
     // Wait for all FIFOs to be vacated
     uint8_t lfmt, lrx, ltx, lacq;
     do CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
@@ -53,47 +65,27 @@ static inline int __i2c_24fc1025_access_chunk(dif_i2c_t *i2c, void *buf, uint64_
     // Disable host until TX FIFO contains entire TX data to prevent (fatal) TX stalls
     clint_spin_ticks(1);
     CHECK_CALL(dif_i2c_host_set_enabled(i2c, kDifToggleDisabled))
-    // 0xA0 identifies an 24FC1025 on the bus, followed by block and chip selects.
-    // We overflow addresses to that device's upper block first, then further devices if any.
-    uint64_t ctrl_waddr = 0xA0 | ((addr & 0x10000) >> 1) | ((addr & 0x1100000) >> 4);
+    uint64_t ctrl_waddr = __i2c_24fc1025_ctrl(addr);
     // Write address
     CHECK_CALL(dif_i2c_write_byte(i2c, ctrl_waddr, kDifI2cFmtStart, true))
     CHECK_CALL(dif_i2c_write_byte(i2c, (addr >> 8) & 0xFF, kDifI2cFmtTx, true))
-    CHECK_CALL(dif_i2c_write_byte(i2c, addr & 0xFF, write ? kDifI2cFmtTx : kDifI2cFmtTxStop, true))
-    // From here, either read from or write to bus
-    if (write) {
-        // For safe writes, we make *two* writes of half-block size.
-        // Fill at most half the FIFO immediately to avoid overflow
-        uint64_t half_fill = I2C_PARAM_FIFO_DEPTH / 2;
-        // Send out all except last byte of half transfer, which needs stop bit
-        for (uint64_t b = 0; b < MIN(len - 1, half_fill); b++)
-            CHECK_CALL(dif_i2c_write_byte(i2c, ((uint8_t *)buf)[b], kDifI2cFmtTx, true))
-        // Send out last byte with stop bit
-        CHECK_CALL(dif_i2c_write_byte(i2c, ((uint8_t *)buf)[len - 1], kDifI2cFmtTx, true))
-        // Enable the host to launch the half transfer
-        CHECK_CALL(dif_i2c_host_set_enabled(i2c, kDifToggleEnabled))
-        // If our length exceeded half the FIFO, invoke another half transfer
-        if (len > half_fill)
-            CHECK_CALL(__i2c_24fc1025_access_chunk(i2c, buf + len, addr + len, len - half_fill, 1))
-    } else {
-        // Request read of len bytes
-        uint64_t ctrl_rdata = ctrl_waddr | 0x1;
-        CHECK_CALL(dif_i2c_write_byte(i2c, ctrl_rdata, kDifI2cFmtStart, true))
-        CHECK_CALL(dif_i2c_write_byte(i2c, len, kDifI2cFmtRx, false))
-        // Re-enable host (no more bytes to write for this chunk)
-        CHECK_CALL(dif_i2c_host_set_enabled(i2c, kDifToggleEnabled))
-        // Wait for read chunk to be fully received
-        do CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
-        while (lrx < len);
-        // Transfer chunk to memory destination
-        for (uint64_t b = 0; b < len; b++) CHECK_CALL(dif_i2c_read_byte(i2c, buf + b))
-    }
+    CHECK_CALL(dif_i2c_write_byte(i2c, addr & 0xFF, kDifI2cFmtTxStop, true))
+    // Request read of len bytes
+    uint64_t ctrl_rdata = ctrl_waddr | 0x1;
+    CHECK_CALL(dif_i2c_write_byte(i2c, ctrl_rdata, kDifI2cFmtStart, true))
+    CHECK_CALL(dif_i2c_write_byte(i2c, len, kDifI2cFmtRx, false))
+    // Re-enable host (no more bytes to write for this chunk)
+    CHECK_CALL(dif_i2c_host_set_enabled(i2c, kDifToggleEnabled))
+    // Wait for read chunk to be fully received
+    do CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
+    while (lrx < len);
+    // Transfer chunk to memory destination
+    for (uint64_t b = 0; b < len; b++) CHECK_CALL(dif_i2c_read_byte(i2c, buf + b))
     // Nothing went wrong
     return 0;
 }
 
-static inline int __i2c_24fc1025_access(void *priv, void *buf, uint64_t addr, uint64_t len,
-                                        int write) {
+int i2c_24fc1025_read(void *priv, void *buf, uint64_t addr, uint64_t len) {
     // Ensure that FIFO size divides device pages (and hence is a power of two)
     CHECK_ASSERT(0x13, 128 % I2C_PARAM_FIFO_DEPTH == 0);
     // The private pointer passed is an I2C handle
@@ -103,21 +95,142 @@ static inline int __i2c_24fc1025_access(void *priv, void *buf, uint64_t addr, ui
     uint64_t offs = 0;
     if (addr_offs) {
         offs = I2C_PARAM_FIFO_DEPTH - addr_offs;
-        CHECK_CALL(__i2c_24fc1025_access_chunk(i2c, buf, addr, offs, write))
+        CHECK_CALL(__i2c_24fc1025_read_chunk(i2c, buf, addr, offs))
     }
     // Copy start-aligned chunks
     for (; offs < len; offs += I2C_PARAM_FIFO_DEPTH) {
         uint64_t chunk_len = MIN(I2C_PARAM_FIFO_DEPTH, len - offs);
-        CHECK_CALL(__i2c_24fc1025_access_chunk(i2c, buf + offs, addr + offs, chunk_len, write))
+        CHECK_CALL(__i2c_24fc1025_read_chunk(i2c, buf + offs, addr + offs, chunk_len))
     }
     // Nothing went wrong
     return 0;
 }
 
-int i2c_24fc1025_read(void *priv, void *buf, uint64_t addr, uint64_t len) {
-    return __i2c_24fc1025_access(priv, buf, addr, len, 0);
+// Request the next chunk of at most half a FIFO of read data, advancing the requested length
+static inline int __i2c_24fc1025_request_rx(dif_i2c_t *i2c, uint64_t *req, uint64_t len) {
+    uint64_t num = MIN(I2C_PARAM_FIFO_DEPTH / 2, len - *req);
+    *req += num;
+    // Continue reading (acknowledging the last byte) unless this is the last chunk
+    return dif_i2c_write_byte(i2c, num, (*req < len) ? kDifI2cFmtRxContinue : kDifI2cFmtRxStop,
+                              false);
+}
+
+// Sequentially read within one 64 KiB block using a single read command
+static inline BOOT_HOT int __i2c_24fc1025_stream_block(dif_i2c_t *i2c, void *buf,
+                                                       uint64_t addr, uint64_t len) {
+    // Wait for all FIFOs to be vacated
+    uint8_t lfmt, lrx, ltx, lacq;
+    do CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
+    while (lfmt || lrx || ltx || lacq);
+    // Disable host until the format FIFO holds the command and first chunks
+    clint_spin_ticks(1);
+    CHECK_CALL(dif_i2c_host_set_enabled(i2c, kDifToggleDisabled))
+    // Write address, then start reading
+    uint64_t ctrl_waddr = __i2c_24fc1025_ctrl(addr);
+    CHECK_CALL(dif_i2c_write_byte(i2c, ctrl_waddr, kDifI2cFmtStart, true))
+    CHECK_CALL(dif_i2c_write_byte(i2c, (addr >> 8) & 0xFF, kDifI2cFmtTx, true))
+    CHECK_CALL(dif_i2c_write_byte(i2c, addr & 0xFF, kDifI2cFmtTxStop, true))
+    CHECK_CALL(dif_i2c_write_byte(i2c, ctrl_waddr | 0x1, kDifI2cFmtStart, true))
+    // Request up to two half-FIFO chunks so that the RX FIFO can never overflow
+    uint64_t req = 0, got = 0;
+    for (int i = 0; i < 2 && req < len; ++i) CHECK_CALL(__i2c_24fc1025_request_rx(i2c, &req, len))
+    CHECK_CALL(dif_i2c_host_set_enabled(i2c, kDifToggleEnabled))
+    // Whenever the RX FIFO reaches its half-full watermark, drain it and request another chunk.
+    // This leaves the bus one chunk of time to refill the FIFO, so it never idles.
+    while (got < len) {
+        uint64_t num = MIN(I2C_PARAM_FIFO_DEPTH / 2, len - got);
+        do CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
+        while (lrx < num);
+        for (uint64_t b = 0; b < num; b++) CHECK_CALL(dif_i2c_read_byte(i2c, buf + got + b))
+        got += num;
+        if (req < len) CHECK_CALL(__i2c_24fc1025_request_rx(i2c, &req, len))
+    }
+    // Nothing went wrong
+    return 0;
+}
+
+BOOT_HOT int i2c_24fc1025_stream_read(void *priv, void *buf, uint64_t addr, uint64_t len) {
+    // The private pointer passed is an I2C handle
+    dif_i2c_t *i2c = (dif_i2c_t *)priv;
+    // The device address counter wraps within 64 KiB blocks, so we issue one read per block
+    for (uint64_t offs = 0; offs < len;) {
+        uint64_t block_len = MIN(0x10000 - ((addr + offs) & 0xFFFF), len - offs);
+        CHECK_CALL(__i2c_24fc1025_stream_block(i2c, buf + offs, addr + offs, block_len))
+        offs += block_len;
+    }
+    // Nothing went wrong
+    return 0;
+}
+
+// Poll the device with its control byte until it acknowledges, i.e. finished its write cycle
+static inline int __i2c_24fc1025_ack_poll(dif_i2c_t *i2c, uint64_t ctrl_waddr) {
+    uint8_t lfmt, lrx, ltx, lacq;
+    bool nak;
+    do {
+        CHECK_CALL(dif_i2c_irq_acknowledge(i2c, kDifI2cIrqNak))
+        // Do not suppress a NAK on the control byte; follow with a dummy address byte to stop
+        CHECK_CALL(dif_i2c_write_byte(i2c, ctrl_waddr, kDifI2cFmtStart, false))
+        CHECK_CALL(dif_i2c_write_byte(i2c, 0, kDifI2cFmtTxStop, true))
+        // The host fetches the address byte only once the control byte was acknowledged
+        do {
+            CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
+            CHECK_CALL(dif_i2c_irq_is_pending(i2c, kDifI2cIrqNak, &nak))
+        } while (lfmt && !nak);
+        // On a NAK, drop the pending address byte
+        if (nak) CHECK_CALL(dif_i2c_reset_fmt_fifo(i2c))
+    } while (nak);
+    // Nothing went wrong
+    return 0;
+}
+
+// Queue one data byte of a page write; the last one carries the stop condition
+static inline int __i2c_24fc1025_write_data(dif_i2c_t *i2c, uint8_t *src, uint64_t b,
+                                            uint64_t len) {
+    return dif_i2c_write_byte(i2c, src[b], (b == len - 1) ? kDifI2cFmtTxStop : kDifI2cFmtTx, true);
+}
+
+// Write (part of) one 128B page, then wait for the write cycle to complete
+static inline int __i2c_24fc1025_write_page(dif_i2c_t *i2c, void *buf, uint64_t addr,
+                                            uint64_t len) {
+    // Wait for all FIFOs to be vacated
+    uint8_t lfmt, lrx, ltx, lacq;
+    do CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
+    while (lfmt || lrx || ltx || lacq);
+    // Disable host until the format FIFO is filled to prevent (fatal) TX stalls
+    clint_spin_ticks(1);
+    CHECK_CALL(dif_i2c_host_set_enabled(i2c, kDifToggleDisabled))
+    // Write address
+    uint64_t ctrl_waddr = __i2c_24fc1025_ctrl(addr);
+    CHECK_CALL(dif_i2c_write_byte(i2c, ctrl_waddr, kDifI2cFmtStart, true))
+    CHECK_CALL(dif_i2c_write_byte(i2c, (addr >> 8) & 0xFF, kDifI2cFmtTx, true))
+    CHECK_CALL(dif_i2c_write_byte(i2c, addr & 0xFF, kDifI2cFmtTx, true))
+    // Fill the rest of the FIFO with data before launching the transfer
+    uint64_t b = 0;
+    for (; b < MIN(len, I2C_PARAM_FIFO_DEPTH - 3); ++b)
+        CHECK_CALL(__i2c_24fc1025_write_data(i2c, buf, b, len))
+    CHECK_CALL(dif_i2c_host_set_enabled(i2c, kDifToggleEnabled))
+    // Top up the FIFO whenever it is half empty, so it never runs dry mid-page
+    while (b < len) {
+        do CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
+        while (lfmt > I2C_PARAM_FIFO_DEPTH / 2);
+        for (; b < len && lfmt < I2C_PARAM_FIFO_DEPTH; ++b, ++lfmt)
+            CHECK_CALL(__i2c_24fc1025_write_data(i2c, buf, b, len))
+    }
+    // Wait for the page to be sent, then acknowledge-poll until the write cycle is done
+    do CHECK_CALL(dif_i2c_get_fifo_levels(i2c, &lfmt, &lrx, &ltx, &lacq))
+    while (lfmt);
+    return __i2c_24fc1025_ack_poll(i2c, ctrl_waddr);
 }
 
 int i2c_24fc1025_write(void *priv, void *buf, uint64_t addr, uint64_t len) {
-    return __i2c_24fc1025_access(priv, buf, addr, len, 1);
+    // The private pointer passed is an I2C handle
+    dif_i2c_t *i2c = (dif_i2c_t *)priv;
+    // Write page by page, as the device address counter wraps within 128B pages
+    for (uint64_t offs = 0; offs < len;) {
+        uint64_t page_len = MIN(128 - ((addr + offs) & 0x7F), len - offs);
+        CHECK_CALL(__i2c_24fc1025_write_page(i2c, buf + offs, addr + offs, page_len))
+        offs += page_len;
+    }
+    // Nothing went wrong
+    return 0;
 }
@@ -81,6 +81,149 @@ static inline int __spi_s25fs512s_poll_wip(spi_s25fs512s_t *handle) {
     return status_reg_1 & 0b01100000;
 }
 
+// Set the write enable latch (WREN); the device clears it after each program, erase, or write
+static inline int __spi_s25fs512s_wren(spi_s25fs512s_t *handle) {
+    dif_spi_host_segment_t wren = {kDifSpiHostSegmentTypeOpcode, {.opcode = 0x06}};
+    return dif_spi_host_transaction(&handle->spi_host, handle->csid, &wren, 1);
+}
+
+// Write a volatile configuration register using WRAR; assumes 3B register addresses (CR2V.AL=0)
+static inline int __spi_s25fs512s_write_any_reg(spi_s25fs512s_t *handle, uint32_t addr,
+                                                uint8_t val) {
+    CHECK_CALL(__spi_s25fs512s_wren(handle))
+    dif_spi_host_segment_t segs[] = {
+        {kDifSpiHostSegmentTypeOpcode, {.opcode = 0x71}},
+        {kDifSpiHostSegmentTypeAddress,
+         {.address = {.width = kDifSpiHostWidthStandard,
+                      .mode = kDifSpiHostAddrMode3b,
+                      .address = addr}}},
+        {kDifSpiHostSegmentTypeTx,
+         {.tx = {.width = kDifSpiHostWidthStandard, .buf = &val, .length = 1}}}};
+    CHECK_CALL(dif_spi_host_transaction(&handle->spi_host, handle->csid, segs, 3))
+    // Poll WIP until register write is complete
+    CHECK_CALL(__spi_s25fs512s_poll_wip(handle))
+    // Nothing went wrong
+    return 0;
+}
+
+// Read a configuration register using RDAR; assumes 3B register addresses (CR2V.AL=0). Dummy
+// cycles follow the read latency code, which is the factory default of 8 unless set up.
+static inline int __spi_s25fs512s_read_any_reg(spi_s25fs512s_t *handle, uint32_t addr,
+                                               uint8_t *val) {
+    dif_spi_host_segment_t segs[] = {
+        {kDifSpiHostSegmentTypeOpcode, {.opcode = 0x65}},
+        {kDifSpiHostSegmentTypeAddress,
+         {.address = {.width = kDifSpiHostWidthStandard,
+                      .mode = kDifSpiHostAddrMode3b,
+                      .address = addr}}},
+        {kDifSpiHostSegmentTypeDummy,
+         {.dummy = {.width = kDifSpiHostWidthStandard,
+                    .length = handle->quad ? handle->latency : 8}}},
+        {kDifSpiHostSegmentTypeRx,
+         {.rx = {.width = kDifSpiHostWidthStandard, .buf = val, .length = 1}}}};
+    // Omit the dummy segment for a zero latency code
+    if (handle->quad && handle->latency == 0) segs[2] = segs[3];
+    CHECK_CALL(dif_spi_host_transaction(&handle->spi_host, handle->csid, segs,
+                                        (handle->quad && handle->latency == 0) ? 3 : 4))
+    // Nothing went wrong
+    return 0;
+}
+
+int spi_s25fs512s_setup_quad(spi_s25fs512s_t *handle, uint8_t latency) {
+    // Latency code is a 4-bit field
+    CHECK_ASSERT(0x17, latency < 16)
+    // Read CR1V (RDCR) and set its QUAD bit, preserving protection settings
+    uint8_t cr1v;
+    dif_spi_host_segment_t segs[] = {
+        {kDifSpiHostSegmentTypeOpcode, {.opcode = 0x35}},
+        {kDifSpiHostSegmentTypeRx,
+         {.rx = {.width = kDifSpiHostWidthStandard, .buf = &cr1v, .length = 1}}}};
+    CHECK_CALL(dif_spi_host_transaction(&handle->spi_host, handle->csid, segs, 2))
+    CHECK_CALL(__spi_s25fs512s_write_any_reg(handle, 0x800002, cr1v | 0x02))
+    // Set CR2V: 3B register addresses, no QPI, IO3 not used as reset, requested latency code
+    CHECK_CALL(__spi_s25fs512s_write_any_reg(handle, 0x800003, latency))
+    // Quad I/O reads may now be used
+    handle->latency = latency;
+    handle->quad = 1;
+    // Nothing went wrong
+    return 0;
+}
+
+static inline int __spi_s25fs512s_quad_read_chunk(spi_s25fs512s_t *handle, void *buf,
+                                                  uint64_t addr, uint64_t len) {
+    // Mode bits other than 0xAx keep the device out of continuous read mode
+    const uint8_t mode = 0x00;
+    // Define 5 segments: opcode, address, mode bits, dummy cycles, RX of data
+    dif_spi_host_segment_t segs[] = {
+        {kDifSpiHostSegmentTypeOpcode, {.opcode = 0xEC}},
+        {kDifSpiHostSegmentTypeAddress,
+         {.address = {.width = kDifSpiHostWidthQuad,
+                      .mode = kDifSpiHostAddrMode4b,
+                      .address = addr}}},
+        {kDifSpiHostSegmentTypeTx,
+         {.tx = {.width = kDifSpiHostWidthQuad, .buf = &mode, .length = 1}}},
+        {kDifSpiHostSegmentTypeDummy,
+         {.dummy = {.width = kDifSpiHostWidthQuad, .length = handle->latency}}},
+        {kDifSpiHostSegmentTypeRx,
+         {.rx = {.width = kDifSpiHostWidthQuad, .buf = buf, .length = len}}}};
+    // Omit the dummy segment for a zero latency code
+    if (handle->latency == 0) segs[3] = segs[4];
+    CHECK_CALL(dif_spi_host_transaction(&handle->spi_host, handle->csid, segs,
+                                        handle->latency ? 5 : 4))
+    // Nothing went wrong
+    return 0;
+}
+
+int spi_s25fs512s_quad_read(void *priv, void *buf, uint64_t addr, uint64_t len) {
+    // The private pointer passed is a device handle
+    spi_s25fs512s_t *handle = (spi_s25fs512s_t *)priv;
+    // Quad I/O must have been set up; top speed for the used command is 133 MHz
+    CHECK_ASSERT(0x18, handle->quad)
+    CHECK_ASSERT(0x19, handle->spi_freq <= 133 * 1000 * 1000)
+    // Copy in chunks (no alignment necessary)
+    for (uint64_t offs = 0; offs < len; offs += 4 * SPI_HOST_PARAM_RX_DEPTH) {
+        uint64_t chunk_len = MIN(4 * SPI_HOST_PARAM_RX_DEPTH, len - offs);
+        CHECK_CALL(__spi_s25fs512s_quad_read_chunk(handle, buf + offs, addr + offs, chunk_len))
+    }
+    // Nothing went wrong
+    return 0;
+}
+
+BOOT_HOT int spi_s25fs512s_stream_read(void *priv, void *buf, uint64_t addr, uint64_t len) {
+    // The private pointer passed is a device handle
+    spi_s25fs512s_t *handle = (spi_s25fs512s_t *)priv;
+    // Use quad I/O reads if set up; top speed is 133 MHz for these and 50 MHz otherwise
+    CHECK_ASSERT(0x1A, handle->quad ? handle->spi_freq <= 133 * 1000 * 1000
+                                    : handle->spi_freq < 50 * 1000 * 1000)
+    if (len == 0) return 0;
+    dif_spi_host_width_t width = handle->quad ? kDifSpiHostWidthQuad : kDifSpiHostWidthStandard;
+    // Mode bits other than 0xAx keep the device out of continuous read mode
+    const uint8_t mode = 0x00;
+    // Issue the command once, keeping CS asserted: opcode, address, mode bits, dummy cycles
+    dif_spi_host_segment_t segs[] = {
+        {kDifSpiHostSegmentTypeOpcode, {.opcode = handle->quad ? 0xEC : 0x13}},
+        {kDifSpiHostSegmentTypeAddress,
+         {.address = {.width = width, .mode = kDifSpiHostAddrMode4b, .address = addr}}},
+        {kDifSpiHostSegmentTypeTx, {.tx = {.width = width, .buf = &mode, .length = 1}}},
+        {kDifSpiHostSegmentTypeDummy, {.dummy = {.width = width, .length = handle->latency}}}};
+    uint64_t num_segs = handle->quad ? (handle->latency ? 4 : 3) : 2;
+    CHECK_CALL(dif_spi_host_transaction_csaat(&handle->spi_host, handle->csid, segs, num_segs))
+    // Drain data in FIFO-sized chunks as it arrives; the device keeps incrementing the address
+    for (uint64_t offs = 0; offs < len; offs += 4 * SPI_HOST_PARAM_RX_DEPTH) {
+        uint64_t chunk_len = MIN(4 * SPI_HOST_PARAM_RX_DEPTH, len - offs);
+        dif_spi_host_segment_t rx = {
+            kDifSpiHostSegmentTypeRx,
+            {.rx = {.width = width, .buf = buf + offs, .length = chunk_len}}};
+        // Release CS only after the last chunk
+        if (offs + chunk_len < len)
+            CHECK_CALL(dif_spi_host_transaction_csaat(&handle->spi_host, handle->csid, &rx, 1))
+        else
+            CHECK_CALL(dif_spi_host_transaction(&handle->spi_host, handle->csid, &rx, 1))
+    }
+    // Nothing went wrong
+    return 0;
+}
+
 static inline int __spi_s25fs512s_single_flash_page(spi_s25fs512s_t *handle, void *buf,
                                                     uint64_t page) {
     // Erase two 256B sectors, equal to one 512B page
@@ -125,3 +268,83 @@ int spi_s25fs512s_single_flash(void *priv, void *buf, uint64_t page, uint64_t nu
     // Nothing went wrong
     return 0;
 }
+
+// Erase one uniform sector (4SE)
+static inline int __spi_s25fs512s_erase_sector(spi_s25fs512s_t *handle, uint64_t addr) {
+    CHECK_CALL(__spi_s25fs512s_wren(handle))
+    dif_spi_host_segment_t segs[] = {{kDifSpiHostSegmentTypeOpcode, {.opcode = 0xDC}},
+                                     {kDifSpiHostSegmentTypeAddress,
+                                      {.address = {.width = kDifSpiHostWidthStandard,
+                                                   .mode = kDifSpiHostAddrMode4b,
+                                                   .address = addr}}}};
+    CHECK_CALL(dif_spi_host_transaction(&handle->spi_host, handle->csid, segs, 2))
+    // Poll WIP until erase is complete
+    return __spi_s25fs512s_poll_wip(handle);
+}
+
+// Program (part of) one page, with quad data (4QPP) if set up and single data (4PP) otherwise
+static inline int __spi_s25fs512s_program_page(spi_s25fs512s_t *handle, void *buf, uint64_t addr,
+                                               uint64_t len) {
+    CHECK_CALL(__spi_s25fs512s_wren(handle))
+    dif_spi_host_segment_t segs[] = {
+        {kDifSpiHostSegmentTypeOpcode, {.opcode = handle->quad ? 0x34 : 0x12}},
+        {kDifSpiHostSegmentTypeAddress,
+         {.address = {.width = kDifSpiHostWidthStandard,
+                      .mode = kDifSpiHostAddrMode4b,
+                      .address = addr}}},
+        {kDifSpiHostSegmentTypeTx,
+         {.tx = {.width = handle->quad ? kDifSpiHostWidthQuad : kDifSpiHostWidthStandard,
+                 .buf = buf,
+                 .length = len}}}};
+    CHECK_CALL(dif_spi_host_transaction(&handle->spi_host, handle->csid, segs, 3))
+    // Poll WIP until programming is complete
+    return __spi_s25fs512s_poll_wip(handle);
+}
+
+int spi_s25fs512s_flash(void *priv, void *buf, uint64_t addr, uint64_t len) {
+    // The private pointer passed is a device handle
+    spi_s25fs512s_t *handle = (spi_s25fs512s_t *)priv;
+    // Top speed for the used commands is 100 MHz; we must start on a sector
+    CHECK_ASSERT(0x1B, handle->spi_freq < 100 * 1000 * 1000)
+    CHECK_ASSERT(0x1C, addr % SPI_S25FS512S_SECTOR_SIZE == 0)
+    // Sector and page sizes assume uniform sectors (CR3V[3], no 4 KiB parameter sectors
+    // overlaid on the first or last sector) and a 512B page buffer wrap (CR3V[4]). These
+    // are set in CR3NV and not by us; refuse to flash with any other configuration.
+    uint8_t cr3v;
+    CHECK_CALL(__spi_s25fs512s_read_any_reg(handle, 0x800004, &cr3v))
+    CHECK_ASSERT(0x1D, (cr3v & 0x18) == 0x18)
+    uint8_t page[SPI_S25FS512S_PAGE_SIZE];
+    for (uint64_t sect = 0; sect < len; sect += SPI_S25FS512S_SECTOR_SIZE) {
+        uint64_t sect_len = MIN(SPI_S25FS512S_SECTOR_SIZE, len - sect);
+        // Compare sector with new data, noting changed pages and whether any bit must be set.
+        // Programming can only clear bits, so this is the only case requiring an erase.
+        uint64_t dirty[SPI_S25FS512S_SECTOR_SIZE / SPI_S25FS512S_PAGE_SIZE / 64] = {0};
+        int erase = 0;
+        for (uint64_t p = 0; p < sect_len && !erase; p += SPI_S25FS512S_PAGE_SIZE) {
+            uint64_t page_len = MIN(SPI_S25FS512S_PAGE_SIZE, sect_len - p);
+            uint8_t *src = (uint8_t *)buf + sect + p;
+            uint64_t idx = p / SPI_S25FS512S_PAGE_SIZE;
+            CHECK_CALL(spi_s25fs512s_stream_read(handle, page, addr + sect + p, page_len))
+            for (uint64_t b = 0; b < page_len; ++b) {
+                if (page[b] != src[b]) dirty[idx / 64] |= 1UL << (idx % 64);
+                if (~page[b] & src[b]) erase = 1;
+            }
+        }
+        if (erase) CHECK_CALL(__spi_s25fs512s_erase_sector(handle, addr + sect))
+        // Program changed pages; after an erase, these are all pages not left blank
+        for (uint64_t p = 0; p < sect_len; p += SPI_S25FS512S_PAGE_SIZE) {
+            uint64_t page_len = MIN(SPI_S25FS512S_PAGE_SIZE, sect_len - p);
+            uint8_t *src = (uint8_t *)buf + sect + p;
+            uint64_t idx = p / SPI_S25FS512S_PAGE_SIZE;
+            int program = 0;
+            if (erase)
+                for (uint64_t b = 0; b < page_len && !program; ++b) program = (src[b] != 0xFF);
+            else
+                program = (dirty[idx / 64] >> (idx % 64)) & 1;
+            if (program)
+                CHECK_CALL(__spi_s25fs512s_program_page(handle, src, addr + sect + p, page_len))
+        }
+    }
+    // Nothing went wrong
+    return 0;
+}
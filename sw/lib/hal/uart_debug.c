@@ -8,13 +8,19 @@
 #include "dif/uart.h"
 #include "util.h"
 #include "params.h"
+#include "crc32.h"
 
 // UART debug opcodes
 typedef enum {
     kUartDebugCmdRead = 0x11,
     kUartDebugCmdWrite = 0x12,
     kUartDebugCmdExec = 0x13,
+    kUartDebugCmdWriteLz = 0x15,
+    kUartDebugCmdWriteWin = 0x16,
+    kUartDebugCmdSetBaud = 0x17,
     kUartDebugAck = 0x06, // Starts debug or acknowledges parsed command
+    kUartDebugNak = 0x18, // Requests retransmission of a windowed write frame
+    kUartDebugSoh = 0x01, // Starts a windowed write frame
     kUartDebugEot = 0x04, // Sent on end of (read/write) transmission
     kUartDebugEoc = 0x14  // Sent when code invoked with EXEC returns
 } uart_debug_opcode_t;
@@ -30,17 +36,122 @@ int uart_debug_init(void *uart_base, uint64_t core_freq) {
     return 0;
 }
 
+// Receive `clen` bytes of LZ-coded data and decompress them to `len` bytes at `dst`.
+// Each token is either a literal run (0x00-0x7F: copy the following token+1 bytes) or
+// a match (0x80-0xFF: repeat (token & 0x7F)+3 bytes from a 16-bit LE offset back).
+// Matches may overlap their output, which also encodes runs of repeated bytes.
+static int uart_debug_read_lz(void *uart_base, uint8_t *dst, uint64_t len, uint64_t clen) {
+    uint64_t out = 0, in = 0;
+    while (in < clen) {
+        uint8_t tok = uart_read(uart_base);
+        uint64_t num;
+        in++;
+        if (tok < 0x80) {
+            num = tok + 1;
+            CHECK_ASSERT(0x11, in + num <= clen && out + num <= len);
+            uart_read_str(uart_base, &dst[out], num);
+            in += num;
+            out += num;
+        } else {
+            uint64_t off;
+            num = (tok & 0x7F) + 3;
+            CHECK_ASSERT(0x12, in + 2 <= clen && out + num <= len);
+            off = uart_read(uart_base);
+            off |= (uint64_t)uart_read(uart_base) << 8;
+            in += 2;
+            CHECK_ASSERT(0x13, off != 0 && off <= out);
+            for (uint64_t i = 0; i < num; ++i, ++out) dst[out] = dst[out - off];
+        }
+    }
+    CHECK_ASSERT(0x14, out == len);
+    return 0;
+}
+
+// Read a byte and add it to a running CRC32
+static inline uint8_t uart_debug_read_crc32(void *uart_base, uint32_t *crc) {
+    uint8_t data = uart_read(uart_base);
+    *crc = crc32_update(*crc, &data, 1);
+    return data;
+}
+
+static void uart_debug_reply_idx(void *uart_base, uint8_t code, uint32_t idx) {
+    uart_write(uart_base, code);
+    uart_write_str(uart_base, &idx, sizeof(uint32_t));
+}
+
+// Receive `len` bytes to `dst` as frames of `blk` bytes (SOH idx32 data crc32), where the
+// CRC covers the index and data. The sender may stream frames back-to-back. We acknowledge
+// in-order frames cumulatively (ACK idx32, the next expected frame). On a missing frame,
+// we reply NAK idx32 once, then drop frames until the sender has rewound. Each corrupted copy
+// of the expected frame is NAKed again, so a retransmission failing too is also recovered.
+static int uart_debug_read_win(void *uart_base, uint8_t *dst, uint64_t len, uint64_t blk) {
+    CHECK_ASSERT(0x11, blk != 0 && len / blk < 0xFFFFFFFF);
+    uint32_t num = (len + blk - 1) / blk;
+    uint32_t exp = 0;
+    int nak_sent = 0;
+    while (exp < num) {
+        uint32_t idx = 0, crc = -1, rx_crc;
+        // Hunt for the start of a frame; drop frames with corrupted indices
+        if (uart_read(uart_base) != kUartDebugSoh) continue;
+        for (int i = 0; i < 32; i += 8) idx |= (uint32_t)uart_debug_read_crc32(uart_base, &crc) << i;
+        if (idx >= num) continue;
+        // Only the expected frame is written to its destination
+        uint64_t flen = MIN(blk, len - idx * blk);
+        uint8_t *fdst = &dst[idx * blk];
+        for (uint64_t i = 0; i < flen; ++i) {
+            uint8_t data = uart_debug_read_crc32(uart_base, &crc);
+            if (idx == exp) fdst[i] = data;
+        }
+        uart_read_str(uart_base, &rx_crc, sizeof(uint32_t));
+        if (idx == exp && ~crc == rx_crc) {
+            nak_sent = 0;
+            uart_debug_reply_idx(uart_base, kUartDebugAck, ++exp);
+        } else if (idx < exp) {
+            // Sender may have missed an acknowledge; repeat it
+            uart_debug_reply_idx(uart_base, kUartDebugAck, exp);
+        } else if (idx == exp || !nak_sent) {
+            nak_sent = 1;
+            uart_debug_reply_idx(uart_base, kUartDebugNak, exp);
+        }
+    }
+    return 0;
+}
+
+// Switch to a new baud rate if it can be generated within 3% of the requested rate.
+// The host confirms the new rate with an ACK, which we echo; otherwise, we revert.
+static void uart_debug_set_baud(void *uart_base, uint64_t core_freq, uint64_t *baud,
+                                uint64_t new_baud) {
+    uint64_t divisor = new_baud ? (core_freq + (new_baud << 3)) / (new_baud << 4) : 0;
+    uint64_t actual = divisor ? core_freq / (divisor << 4) : 0;
+    uint64_t error = (actual > new_baud) ? actual - new_baud : new_baud - actual;
+    if (divisor == 0 || divisor > 0xFFFF || error > new_baud / 32) {
+        uart_write(uart_base, kUartDebugNak);
+        return;
+    }
+    uart_write(uart_base, kUartDebugAck);
+    uart_write_flush(uart_base);
+    uart_init(uart_base, core_freq, new_baud);
+    if (uart_read(uart_base) == kUartDebugAck) {
+        uart_write(uart_base, kUartDebugAck);
+        *baud = new_baud;
+    } else {
+        uart_init(uart_base, core_freq, *baud);
+        uart_write(uart_base, kUartDebugNak);
+    }
+}
+
 int uart_debug_check(void *uart_base) {
     return (uart_read_ready(uart_base) && *reg8(uart_base, UART_RBR_REG_OFFSET) == kUartDebugAck);
 }
 
-int uart_debug_serve(void *uart_base) {
+int uart_debug_serve(void *uart_base, uint64_t core_freq) {
+    uint64_t baud = __BOOT_BAUDRATE;
     // Respond to debug request with ACK to initiate connection
     uart_write(uart_base, kUartDebugAck);
     // Parse commands (eventually hit EXEC command or trap)
     while (1) {
         uint8_t cmd;
-        uint64_t addr, len;
+        uint64_t addr, len, clen, blk, rate;
         uint32_t ret;
         fence();
         cmd = uart_read(uart_base);
@@ -61,9 +172,34 @@ int uart_debug_serve(void *uart_base) {
             uart_read_str(uart_base, (void *)(uintptr_t)addr, len);
             uart_write(uart_base, kUartDebugEot);
             break;
+        // WRITELZ addr64 len64 clen64 (->ACK) lz (->EOT)
+        case kUartDebugCmdWriteLz:
+            uart_read_str(uart_base, &addr, sizeof(uint64_t));
+            uart_read_str(uart_base, &len, sizeof(uint64_t));
+            uart_read_str(uart_base, &clen, sizeof(uint64_t));
+            uart_write(uart_base, kUartDebugAck);
+            CHECK_CALL(uart_debug_read_lz(uart_base, (void *)(uintptr_t)addr, len, clen))
+            uart_write(uart_base, kUartDebugEot);
+            break;
+        // WRITEWIN addr64 len64 blk64 (->ACK) frames (->EOT)
+        case kUartDebugCmdWriteWin:
+            uart_read_str(uart_base, &addr, sizeof(uint64_t));
+            uart_read_str(uart_base, &len, sizeof(uint64_t));
+            uart_read_str(uart_base, &blk, sizeof(uint64_t));
+            uart_write(uart_base, kUartDebugAck);
+            CHECK_CALL(uart_debug_read_win(uart_base, (void *)(uintptr_t)addr, len, blk))
+            uart_write(uart_base, kUartDebugEot);
+            break;
+        // SETBAUD baud64 (->ACK) switch (<-ACK ->ACK) or (->NAK)
+        case kUartDebugCmdSetBaud:
+            uart_read_str(uart_base, &rate, sizeof(uint64_t));
+            uart_debug_set_baud(uart_base, core_freq, &baud, rate);
+            break;
         // EXEC addr64 (->ACK) execute
         case kUartDebugCmdExec:
             uart_read_str(uart_base, &addr, sizeof(uint64_t));
+            // Invoked code expects the boot baud rate
+            if (baud != __BOOT_BAUDRATE) uart_init(uart_base, core_freq, __BOOT_BAUDRATE);
             uart_write(uart_base, kUartDebugAck);
             fence();
             ret = invoke((void *)(uintptr_t)addr);
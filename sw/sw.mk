@@ -22,12 +22,19 @@ CHS_SW_ZSL_TGUID := 0269B26A-FD95-4CE4-98CF-941401412C62
 CHS_SW_DTB_TGUID := BA442F61-2AEF-42DE-9233-E4D75D3ACB9D
 CHS_SW_FW_TGUID  := 99EC86DA-3F5B-4B0D-8F4B-C4BACFA5F859
 CHS_SW_DISK_SIZE ?= 16M
+CHS_SW_ZSL_LZ4   ?= 1
 
 CHS_SW_FLAGS   ?= -DOT_PLATFORM_RV32 -march=rv64gc_zifencei -mabi=lp64d -mstrict-align -O2 -Wall -Wextra -static -ffunction-sections -fdata-sections -frandom-seed=cheshire -fuse-linker-plugin -flto -Wl,-flto
 CHS_SW_CCFLAGS ?= $(CHS_SW_FLAGS) -ggdb -mcmodel=medany -mexplicit-relocs -fno-builtin -fverbose-asm -pipe
 CHS_SW_LDFLAGS ?= $(CHS_SW_FLAGS) -nostartfiles -Wl,--gc-sections -Wl,-L$(CHS_SW_LD_DIR)
 CHS_SW_ARFLAGS ?= --plugin=$(CHS_SW_LTOPLUG)
 
+# Whether the boot ROM runs hot code (`BOOT_HOT`) from SPM instead of fetching it from ROM
+CHS_BROM_HOT_SPM ?= 1
+ifeq ($(CHS_BROM_HOT_SPM),1)
+CHS_SW_CCFLAGS += -DCHS_BROM_HOT_SPM
+endif
+
 CHS_SW_ALL += $(CHS_SW_LIBS) $(CHS_SW_GEN_HDRS) $(CHS_SW_TESTS)
 
 .PRECIOUS: %.elf %.dtb
@@ -125,11 +132,15 @@ $(foreach link,$(patsubst $(CHS_SW_LD_DIR)/%.ld,%,$(wildcard $(CHS_SW_LD_DIR)/*.
 # GPT test images #
 ###################
 
+# Partition attribute mask stamping the size of the payload file $(1) in LBAs (bits 48-63);
+# the boot ROM and ZSL then read only the payload instead of the entire partition.
+chs_sw_gpt_attr = $$(printf "0x%016x" $$(( ($$(stat --printf="%s" $(1)) + 511)/512 << 48 )))
+
 # Create a GPT disk image from a (firmware) ROM; we add dummy partitions to test our GPT boot code.
 %.gpt.bin: %.rom.bin
 	rm -f $@
 	truncate -s $$(( ($$(stat --printf="%s" $<)/512 + 85)*512 )) $@
-	sgdisk -Z --clear -g --set-alignment=1 --new=1:37:40 --new=2:42:-9 --typecode=2:$(CHS_SW_ZSL_TGUID) --new=3:-5:-2 $@ &> /dev/null
+	sgdisk -Z --clear -g --set-alignment=1 --new=1:37:40 --new=2:42:-9 --typecode=2:$(CHS_SW_ZSL_TGUID) --attributes=2:=:$(call chs_sw_gpt_attr,$<) --new=3:-5:-2 $@ &> /dev/null
 	dd if=$< of=$@ bs=512 seek=42 conv=notrunc
 
 # Create hex file from .gpt image
@@ -139,13 +150,25 @@ $(foreach link,$(patsubst $(CHS_SW_LD_DIR)/%.ld,%,$(wildcard $(CHS_SW_LD_DIR)/*.
 # Images from CVA6 SDK (built externally)
 CHS_CVA6_SDK_IMGS ?= $(addprefix $(CHS_SW_DIR)/deps/cva6-sdk/install64/,fw_payload.bin uImage)
 
+# Partition images loaded by the ZSL: a payload header, then the payload (LZ4-compressed if enabled)
+CHS_SW_ZSL_PART = $(CHS_ROOT)/util/gen_zslpart.py $(if $(filter 1,$(CHS_SW_ZSL_LZ4)),--lz4) $< $@
+
+$(CHS_SW_DIR)/boot/cheshire.%.part.bin: $(CHS_SW_DIR)/boot/cheshire.%.dtb
+	$(CHS_SW_ZSL_PART)
+
+$(CHS_SW_DIR)/boot/fw_payload.part.bin: $(firstword $(CHS_CVA6_SDK_IMGS))
+	$(CHS_SW_ZSL_PART)
+
+# The ZSL keeps using the boot ROM's block cache in SPM (`__BOOT_CACHE`), so it must end before it
+$(CHS_SW_DIR)/boot/zsl.rom.elf: CHS_SW_LDFLAGS += -Wl,--defsym=__bss_limit=0x1000C000
+
 # Create full Linux disk image
-$(CHS_SW_DIR)/boot/linux.%.gpt.bin: $(CHS_SW_DIR)/boot/zsl.rom.bin $(CHS_SW_DIR)/boot/cheshire.%.dtb $(CHS_CVA6_SDK_IMGS)
+$(CHS_SW_DIR)/boot/linux.%.gpt.bin: $(CHS_SW_DIR)/boot/zsl.rom.bin $(CHS_SW_DIR)/boot/cheshire.%.part.bin $(CHS_SW_DIR)/boot/fw_payload.part.bin $(lastword $(CHS_CVA6_SDK_IMGS))
 	truncate -s $(CHS_SW_DISK_SIZE) $@
 	sgdisk --clear -g --set-alignment=1 \
-		--new=1:64:96 --typecode=1:$(CHS_SW_ZSL_TGUID) \
-		--new=2:128:159 --typecode=2:$(CHS_SW_DTB_TGUID) \
-		--new=3:2048:8191 --typecode=3:$(CHS_SW_FW_TGUID) \
+		--new=1:64:96 --typecode=1:$(CHS_SW_ZSL_TGUID) --attributes=1:=:$(call chs_sw_gpt_attr,$(word 1,$^)) \
+		--new=2:128:159 --typecode=2:$(CHS_SW_DTB_TGUID) --attributes=2:=:$(call chs_sw_gpt_attr,$(word 2,$^)) \
+		--new=3:2048:8191 --typecode=3:$(CHS_SW_FW_TGUID) --attributes=3:=:$(call chs_sw_gpt_attr,$(word 3,$^)) \
 		--new=4:8192:24575 --typecode=4:8300 \
 		--new=5:24576:0 --typecode=5:8200 \
 		$@
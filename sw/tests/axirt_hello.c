@@ -19,7 +19,7 @@
 int main(void) {
     char str[] = "Hello AXI-RT!\r\n";
     uint32_t rtc_freq = *reg32(&__base_regs, CHESHIRE_RTC_FREQ_REG_OFFSET);
-    uint64_t reset_freq = clint_get_core_freq(rtc_freq, 2500);
+    uint64_t reset_freq = clint_get_core_freq_handoff(rtc_freq, 2500);
 
     // enable and configure axi rt
     __axirt_claim(1, 1);
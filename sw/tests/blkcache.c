@@ -0,0 +1,108 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Checks the block cache against direct reads from a mock device in memory: reads crossing
+// block boundaries, unaligned reads, LRU eviction, the aligned-block bypass, and reads at
+// the device end, where a full block cannot be fetched.
+
+#include "regs/cheshire.h"
+#include "dif/clint.h"
+#include "dif/uart.h"
+#include "blkcache.h"
+#include "params.h"
+#include "util.h"
+#include "printf.h"
+
+// The device is not a whole number of cache blocks, so the last block cannot be fetched
+#define DISK_BYTES (8 * BLKCACHE_BLOCK_SIZE - 0x200)
+#define BUF_BYTES (3 * BLKCACHE_BLOCK_SIZE)
+#define GUARD 0xA5
+
+static uint8_t disk[DISK_BYTES];
+static uint8_t buf[BUF_BYTES + 8];
+static blkcache_t cache;
+
+// Mock device statistics
+static uint64_t dev_reads, dev_last_len;
+
+static int mem_read(void *priv, void *dst, uint64_t addr, uint64_t len) {
+    if (addr + len > DISK_BYTES) return -1;
+    ++dev_reads;
+    dev_last_len = len;
+    for (uint64_t i = 0; i < len; ++i) ((uint8_t *)dst)[i] = ((uint8_t *)priv)[addr + i];
+    return 0;
+}
+
+// Read through the cache and compare with the device, checking that nothing past `len`
+// is written. Returns the number of device reads caused, or -1 on a mismatch.
+static int64_t check(uint64_t addr, uint64_t len) {
+    for (uint64_t i = 0; i < len + 8; ++i) buf[i] = GUARD;
+    uint64_t reads = dev_reads;
+    if (blkcache_read(&cache, buf, addr, len)) return -1;
+    for (uint64_t i = 0; i < len; ++i)
+        if (buf[i] != disk[addr + i]) return -1;
+    for (uint64_t i = len; i < len + 8; ++i)
+        if (buf[i] != GUARD) return -1;
+    return dev_reads - reads;
+}
+
+static int fail(int code, uint64_t addr, uint64_t len) {
+    printf("[BLKCACHE] Check %d failed reading %d B at 0x%x\r\n", code, (int)len, (int)addr);
+    uart_write_flush(&__base_uart);
+    return code;
+}
+
+int main(void) {
+    uint32_t rtc_freq = *reg32(&__base_regs, CHESHIRE_RTC_FREQ_REG_OFFSET);
+    uint64_t reset_freq = clint_get_core_freq_handoff(rtc_freq, 2500);
+    uart_init(&__base_uart, reset_freq, __BOOT_BAUDRATE);
+
+    // Fill device pseudorandomly
+    uint32_t lfsr = 0xACE1;
+    for (uint64_t i = 0; i < DISK_BYTES; ++i) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB4BCD35C);
+        disk[i] = lfsr;
+    }
+    const uint64_t blk = BLKCACHE_BLOCK_SIZE;
+
+    // Read crossing a block boundary fetches both blocks, then hits
+    blkcache_init(&cache, mem_read, disk);
+    if (check(blk - 100, 300) != 2) return fail(1, blk - 100, 300);
+    if (check(blk - 1, 2) != 0) return fail(2, blk - 1, 2);
+
+    // Unaligned reads of odd lengths within cached blocks never reach the device
+    for (uint64_t offs = 1; offs < 64; offs += 7)
+        if (check(offs, 2 * blk - 3 * offs) != 0) return fail(3, offs, 2 * blk - 3 * offs);
+
+    // Eviction: with all blocks used, a fifth block evicts the least recently used one
+    blkcache_init(&cache, mem_read, disk);
+    for (uint64_t b = 0; b < BLKCACHE_BLOCKS; ++b)
+        if (check(b * blk + 5, 1) != 1) return fail(4, b * blk + 5, 1);
+    if (check(1 * blk + 9, 3) != 0) return fail(5, 1 * blk + 9, 3);
+    if (check(BLKCACHE_BLOCKS * blk, 1) != 1) return fail(6, BLKCACHE_BLOCKS * blk, 1);
+    if (check(0, 1) != 1) return fail(7, 0, 1);
+    if (check(1 * blk, 1) != 0) return fail(8, 1 * blk, 1);
+
+    // Whole aligned blocks bypass the cache in a single read; a tail still goes through it
+    blkcache_init(&cache, mem_read, disk);
+    if (check(blk, 2 * blk + 5) != 2 || dev_last_len != blk) return fail(9, blk, 2 * blk + 5);
+    if (check(blk + 7, 1) != 1) return fail(10, blk + 7, 1);
+    if (check(3 * blk + 1, 4) != 0) return fail(11, 3 * blk + 1, 4);
+
+    // At the device end, only the requested bytes are read directly
+    if (check(DISK_BYTES - 10, 10) != 1 || dev_last_len != 10) return fail(12, DISK_BYTES - 10, 10);
+
+    // Random reads
+    blkcache_init(&cache, mem_read, disk);
+    for (int i = 0; i < 256; ++i) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB4BCD35C);
+        uint64_t addr = lfsr % DISK_BYTES;
+        uint64_t len = MIN((lfsr >> 16) % BUF_BYTES, DISK_BYTES - addr);
+        if (check(addr, len) < 0) return fail(13, addr, len);
+    }
+
+    printf("[BLKCACHE] All checks passed\r\n");
+    uart_write_flush(&__base_uart);
+    return 0;
+}
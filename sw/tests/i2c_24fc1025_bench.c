@@ -0,0 +1,59 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Measures I2C EEPROM (24FC1025) write and read throughput in Fast-mode Plus. The tested
+// range crosses a 64 KiB block boundary and is not page-aligned. We read back exactly the
+// written range, so all bytes counted in the read throughput are verified.
+
+#include "regs/cheshire.h"
+#include "dif/clint.h"
+#include "dif/uart.h"
+#include "hal/i2c_24fc1025.h"
+#include "params.h"
+#include "util.h"
+#include "printf.h"
+
+// Chip 0 is write-protected in simulation, so we test chip 1 (A0 = 1) at its block boundary
+#define TEST_ADDR (0x30000 - 200)
+#define TEST_BYTES 512
+
+static uint8_t wbuf[TEST_BYTES];
+static uint8_t rbuf[TEST_BYTES];
+
+// Throughput in bytes per second from bytes transferred and cycles taken
+static int bps(uint64_t bytes, uint64_t cycles, uint64_t core_freq) {
+    return (int)(bytes * core_freq / cycles);
+}
+
+int main(void) {
+    uint32_t rtc_freq = *reg32(&__base_regs, CHESHIRE_RTC_FREQ_REG_OFFSET);
+    uint64_t core_freq = clint_get_core_freq_handoff(rtc_freq, 2500);
+    uart_init(&__base_uart, core_freq, __BOOT_BAUDRATE);
+
+    dif_i2c_t i2c;
+    CHECK_CALL(i2c_24fc1025_init(&i2c, core_freq, 1))
+    for (int i = 0; i < TEST_BYTES; ++i) wbuf[i] = i * 7 + 3;
+
+    // Page writes with acknowledge polling
+    uint64_t start = get_mcycle();
+    CHECK_CALL(i2c_24fc1025_write(&i2c, wbuf, TEST_ADDR, TEST_BYTES))
+    uint64_t write = get_mcycle() - start;
+
+    // Sequential streaming reads
+    start = get_mcycle();
+    CHECK_CALL(i2c_24fc1025_stream_read(&i2c, rbuf, TEST_ADDR, TEST_BYTES))
+    uint64_t read = get_mcycle() - start;
+
+    for (int i = 0; i < TEST_BYTES; ++i)
+        if (rbuf[i] != wbuf[i]) {
+            printf("[I2C] Mismatch at 0x%x\r\n", TEST_ADDR + i);
+            uart_write_flush(&__base_uart);
+            return 1;
+        }
+
+    printf("[I2C] Write: %d B/s, read: %d B/s\r\n", bps(TEST_BYTES, write, core_freq),
+           bps(TEST_BYTES, read, core_freq));
+    uart_write_flush(&__base_uart);
+    return 0;
+}
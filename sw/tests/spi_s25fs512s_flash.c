@@ -0,0 +1,73 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Reflashes a GPT disk image received over UART to the S25FS512S NOR flash at CS1.
+// The host sends the image length (64b LE) and then the image in sector-sized blocks,
+// waiting for an ACK after the length and each block. On failure, we reply NAK and a 32b LE
+// error code. After all blocks, we reply EOT, then print a summary. See `util/uart_flash.py`.
+
+#include "regs/cheshire.h"
+#include "dif/clint.h"
+#include "dif/uart.h"
+#include "hal/spi_s25fs512s.h"
+#include "gpt.h"
+#include "params.h"
+#include "util.h"
+#include "printf.h"
+
+// Same ACK, NAK, and EOT codes as the UART debug protocol
+#define ACK 0x06
+#define NAK 0x18
+#define EOT 0x04
+
+// Receive sectors to DRAM well above this program and below its stack
+static uint8_t *const sector_buf = (uint8_t *)0x80400000;
+
+static int mem_read(void *priv, void *buf, uint64_t addr, uint64_t len) {
+    for (uint64_t i = 0; i < len; ++i) ((uint8_t *)buf)[i] = ((uint8_t *)priv)[addr + i];
+    return 0;
+}
+
+static int fail(uint32_t code) {
+    uart_write(&__base_uart, NAK);
+    uart_write_str(&__base_uart, &code, sizeof(code));
+    uart_write_flush(&__base_uart);
+    return code;
+}
+
+int main(void) {
+    uint32_t rtc_freq = *reg32(&__base_regs, CHESHIRE_RTC_FREQ_REG_OFFSET);
+    uint64_t core_freq = clint_get_core_freq_handoff(rtc_freq, 2500);
+    uart_init(&__base_uart, core_freq, __BOOT_BAUDRATE);
+
+    // Set up flash for quad I/O; it has long been powered up by now
+    spi_s25fs512s_t device = {.spi_freq = MIN(50 * 1000 * 1000, core_freq / 4), .csid = 1};
+    CHECK_CALL(spi_s25fs512s_init(&device, core_freq))
+    CHECK_CALL(spi_s25fs512s_setup_quad(&device, 8))
+
+    // Receive image length
+    uint64_t len;
+    uart_read_str(&__base_uart, &len, sizeof(len));
+    if (len > 64 * 1024 * 1024) return fail(0x1);
+    uart_write(&__base_uart, ACK);
+
+    // Receive and flash image sector by sector
+    uint64_t start = get_mcycle();
+    for (uint64_t offs = 0; offs < len; offs += SPI_S25FS512S_SECTOR_SIZE) {
+        uint64_t sect_len = MIN(SPI_S25FS512S_SECTOR_SIZE, len - offs);
+        uart_read_str(&__base_uart, sector_buf, sect_len);
+        if (offs == 0 && !gpt_check_signature(mem_read, sector_buf)) return fail(0x2);
+        int ret = spi_s25fs512s_flash(&device, sector_buf, offs, sect_len);
+        if (ret) return fail(ret);
+        uart_write(&__base_uart, ACK);
+    }
+    uint64_t cycles = get_mcycle() - start;
+
+    // Ensure the flashed disk is readable as GPT
+    if (!gpt_check_signature(spi_s25fs512s_stream_read, &device)) return fail(0x3);
+    uart_write(&__base_uart, EOT);
+    printf("[FLASH] Wrote %d KiB in %d Mcycles\r\n", (int)(len >> 10), (int)(cycles / 1000000));
+    uart_write_flush(&__base_uart);
+    return 0;
+}
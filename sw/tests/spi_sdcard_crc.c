@@ -0,0 +1,68 @@
+// Copyright 2024 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Microbenchmark for the SD card data block CRC16: compares the driver's sliced
+// implementation against a bytewise table lookup and reports cycles per 512B block.
+
+#include "regs/cheshire.h"
+#include "dif/clint.h"
+#include "dif/uart.h"
+#include "hal/spi_sdcard.h"
+#include "params.h"
+#include "util.h"
+#include "printf.h"
+
+#define NUM_BLOCKS 8
+
+static uint8_t blocks[NUM_BLOCKS][512] __attribute__((aligned(8)));
+static uint16_t lookup[256];
+static volatile uint16_t sink;
+
+static uint16_t crc16_bytewise(const uint8_t *data, uint64_t len) {
+    uint16_t state = 0;
+    for (uint64_t i = 0; i < len; ++i) state = lookup[data[i] ^ (state >> 8)] ^ (state << 8);
+    return ((state & 0xFF) << 8) | ((state & 0xFF00) >> 8);
+}
+
+int main(void) {
+    uint32_t rtc_freq = *reg32(&__base_regs, CHESHIRE_RTC_FREQ_REG_OFFSET);
+    uint64_t reset_freq = clint_get_core_freq_handoff(rtc_freq, 2500);
+    uart_init(&__base_uart, reset_freq, __BOOT_BAUDRATE);
+
+    // Build bytewise table for G(x) = x^16 + x^12 + x^5 + 1 and fill blocks pseudorandomly
+    for (int i = 0; i < 256; ++i) {
+        uint16_t c = i << 8;
+        for (int b = 0; b < 8; ++b) c = (c & 0x8000) ? (c << 1) ^ 0x1021 : (c << 1);
+        lookup[i] = c;
+    }
+    uint32_t lfsr = 0xACE1;
+    for (int b = 0; b < NUM_BLOCKS; ++b)
+        for (int i = 0; i < 512; ++i) {
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB4BCD35C);
+            blocks[b][i] = lfsr;
+        }
+
+    // Check sliced CRC against bytewise one, including unaligned starts and odd lengths
+    for (int b = 0; b < NUM_BLOCKS; ++b)
+        for (int offs = 0; offs < 8; ++offs)
+            if (spi_sdcard_crc16(&blocks[b][offs], 512 - 3 * offs) !=
+                crc16_bytewise(&blocks[b][offs], 512 - 3 * offs)) {
+                printf("[CRC] Mismatch in block %d at offset %d\r\n", b, offs);
+                uart_write_flush(&__base_uart);
+                return 1;
+            }
+
+    // Time both implementations on full blocks
+    uint64_t start = get_mcycle();
+    for (int b = 0; b < NUM_BLOCKS; ++b) sink = crc16_bytewise(blocks[b], 512);
+    uint64_t bytewise = get_mcycle() - start;
+    start = get_mcycle();
+    for (int b = 0; b < NUM_BLOCKS; ++b) sink = spi_sdcard_crc16(blocks[b], 512);
+    uint64_t sliced = get_mcycle() - start;
+
+    printf("[CRC] Cycles per 512B block: bytewise %d, sliced %d\r\n", (int)(bytewise / NUM_BLOCKS),
+           (int)(sliced / NUM_BLOCKS));
+    uart_write_flush(&__base_uart);
+    return 0;
+}
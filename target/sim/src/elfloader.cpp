@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <iostream>
 #include <stdint.h>
 
@@ -34,6 +35,7 @@
 #define SHT_NOBITS 8
 #define SHT_PROGBITS 0x1
 #define SHT_GROUP 0x11
+#define STB_GLOBAL 1
 
 typedef struct {
   uint8_t  e_ident[16];
@@ -137,37 +139,110 @@ typedef struct {
   uint64_t st_size;
 } Elf64_Sym;
 
-// address and size
-std::vector<std::pair<uint64_t, uint64_t>> sections;
-
-// memory based address and content
-std::map<uint64_t, std::vector<uint8_t>> mems;
-
-// Entrypoint
-uint64_t entry = 0;
-int section_index = 0;
+// A parsed ELF image; its sections are served directly from the file mapping
+typedef struct {
+  std::string path;
+  struct timespec mtime;
+  off_t fsize;
+  // File mapping backing `mems`
+  char *buf;
+  size_t size;
+  // Entrypoint
+  uint64_t entry;
+  // address and size
+  std::vector<std::pair<uint64_t, uint64_t>> sections;
+  // address and size of ranges that must be zeroed (p_memsz beyond p_filesz)
+  std::vector<std::pair<uint64_t, uint64_t>> zero_fills;
+  // memory based address and content (pointer into the file mapping and file size)
+  std::map<uint64_t, std::pair<const uint8_t *, uint64_t>> mems;
+  // symbol name to address and size
+  std::map<std::string, std::pair<uint64_t, uint64_t>> symbols;
+  // Number of open handles and whether the image is still in the cache
+  unsigned int refs;
+  bool cached;
+} elf_image_t;
+
+// Per-handle view of an image with its own iterators
+typedef struct {
+  elf_image_t *image;
+  size_t section_index;
+  size_t zero_fill_index;
+  // Coalesced, bus-aligned chunks (address and size), planned when iteration starts
+  std::vector<std::pair<uint64_t, uint64_t>> chunks;
+  size_t chunk_index;
+} elf_handle_t;
+
+// Parsed images keyed by path; entries are reused as long as the file is unchanged. This cache
+// only lives as long as the simulator process (e.g. across restarts in one vsim session); it is
+// not persisted, as parsing only walks the headers and symbols while data stays in the mapping.
+static std::map<std::string, elf_image_t *> images;
+
+// Open handles, indexed by the handle number passed over DPI
+static std::vector<elf_handle_t> handles;
 
 extern "C" {
-  char get_entry(long long *entry_ret);
-  char get_section(long long *address_ret, long long *len_ret);
-  char read_section(long long address, const svOpenArrayHandle buffer, long long len);
-  char read_elf(const char *filename);
+  char elf_open(const char *filename, int *handle_ret);
+  char elf_close(int handle);
+  char elf_rewind(int handle);
+  char elf_get_entry(int handle, long long *entry_ret);
+  char elf_get_section(int handle, long long *address_ret, long long *len_ret);
+  char elf_get_zero_fill(int handle, long long *address_ret, long long *len_ret);
+  char elf_read_section(int handle, long long address, const svOpenArrayHandle buffer, long long len);
+  char elf_get_chunk(int handle, long long bus_bytes, long long max_bytes, long long max_gap,
+                     long long *address_ret, long long *len_ret);
+  char elf_read_chunk(int handle, long long address, const svOpenArrayHandle buffer,
+                      const svOpenArrayHandle strobes, long long len);
+  char elf_get_symbol(int handle, const char *name, long long *address_ret, long long *size_ret);
+}
+
+static void free_image(elf_image_t *image)
+{
+  munmap(image->buf, image->size);
+  delete image;
 }
 
-static void write (uint64_t address, uint64_t len, uint8_t *buf)
+static elf_handle_t *get_handle(int handle)
 {
-  std::vector<uint8_t> mem;
-  for (int i = 0; i < len; i++) {
-    mem.push_back(buf[i]);
+  if (handle < 0 || (size_t) handle >= handles.size() || !handles[handle].image) {
+    printf("[ELF] ERROR: Invalid handle %d\n", handle);
+    return NULL;
   }
-  mems.insert(std::make_pair(address, mem));
+  return &handles[handle];
+}
+
+// Record where the content of a section lives; no data is copied here
+static void write (elf_image_t &image, uint64_t address, uint64_t len, const uint8_t *buf)
+{
+  image.mems[address] = std::make_pair(buf, len);
+}
+
+// Release a handle; the image stays cached for later opens
+extern "C" char elf_close(int handle)
+{
+  elf_handle_t *h = get_handle(handle);
+  if (!h) return -1;
+  if (--h->image->refs == 0 && !h->image->cached) free_image(h->image);
+  h->image = NULL;
+  return 0;
+}
+
+// Restart the section and zero-fill iterators of a handle
+extern "C" char elf_rewind(int handle)
+{
+  elf_handle_t *h = get_handle(handle);
+  if (!h) return -1;
+  h->section_index = 0;
+  h->zero_fill_index = 0;
+  h->chunk_index = 0;
+  return 0;
 }
 
 // Return the entry point reported by the ELF file
-// Must be called after reading the elf file obviously
-extern "C" char get_entry(long long *entry_ret)
+extern "C" char elf_get_entry(int handle, long long *entry_ret)
 {
-  *entry_ret = entry;
+  elf_handle_t *h = get_handle(handle);
+  if (!h) return -1;
+  *entry_ret = h->image->entry;
   return 0;
 }
 
@@ -175,45 +250,165 @@ extern "C" char get_entry(long long *entry_ret)
 // Returns:
 // 0 if there are no more sections
 // 1 if there are more sections to load
-extern "C" char get_section(long long *address_ret, long long *len_ret)
+extern "C" char elf_get_section(int handle, long long *address_ret, long long *len_ret)
+{
+  elf_handle_t *h = get_handle(handle);
+  if (h && h->section_index < h->image->sections.size()) {
+    *address_ret = h->image->sections[h->section_index].first;
+    *len_ret = h->image->sections[h->section_index].second;
+    h->section_index++;
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+// Iterator over the ranges to be zeroed after all sections are loaded
+// Returns:
+// 0 if there are no more ranges
+// 1 if there are more ranges to clear
+extern "C" char elf_get_zero_fill(int handle, long long *address_ret, long long *len_ret)
+{
+  elf_handle_t *h = get_handle(handle);
+  if (h && h->zero_fill_index < h->image->zero_fills.size()) {
+    *address_ret = h->image->zero_fills[h->zero_fill_index].first;
+    *len_ret = h->image->zero_fills[h->zero_fill_index].second;
+    h->zero_fill_index++;
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+// Merge segments at most `max_gap` bytes apart, then split the merged ranges into chunks
+// aligned to `bus_bytes` of at most `max_bytes` which do not cross 4 KiB boundaries.
+static void plan_chunks(elf_handle_t *h, uint64_t bus_bytes, uint64_t max_bytes, uint64_t max_gap)
+{
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  std::map<uint64_t, std::pair<const uint8_t *, uint64_t>>::iterator it;
+
+  for (it = h->image->mems.begin(); it != h->image->mems.end(); ++it) {
+    uint64_t begin = it->first, end = it->first + it->second.second;
+    if (begin == end) continue;
+    if (!ranges.empty() && begin <= ranges.back().second + max_gap)
+      ranges.back().second = std::max(end, ranges.back().second);
+    else
+      ranges.push_back(std::make_pair(begin, end));
+  }
+
+  h->chunks.clear();
+  for (size_t i = 0; i < ranges.size(); i++) {
+    uint64_t addr = ranges[i].first & ~(bus_bytes - 1);
+    uint64_t end = (ranges[i].second + bus_bytes - 1) & ~(bus_bytes - 1);
+    while (addr < end) {
+      uint64_t len = std::min(std::min(end - addr, max_bytes), 0x1000 - (addr & 0xFFF));
+      h->chunks.push_back(std::make_pair(addr, len));
+      addr += len;
+    }
+  }
+}
+
+// Iterator over coalesced, bus-aligned chunks of section data; the chunking is
+// planned when iteration starts (or restarts after a rewind).
+// Returns:
+// 0 if there are no more chunks
+// 1 if there are more chunks to load
+extern "C" char elf_get_chunk(int handle, long long bus_bytes, long long max_bytes, long long max_gap,
+                              long long *address_ret, long long *len_ret)
 {
-  if (section_index < sections.size()) {
-    *address_ret = sections[section_index].first;
-    *len_ret = sections[section_index].second;
-    section_index++;
+  elf_handle_t *h = get_handle(handle);
+  if (!h) return 0;
+
+  if (bus_bytes <= 0 || (bus_bytes & (bus_bytes - 1)) || max_bytes < bus_bytes || max_gap < 0) {
+    printf("[ELF] ERROR: Invalid chunk parameters (bus 0x%llx, max 0x%llx, gap 0x%llx)\n",
+           bus_bytes, max_bytes, max_gap);
+    return 0;
+  }
+
+  if (h->chunk_index == 0)
+    plan_chunks(h, bus_bytes, max_bytes & ~(bus_bytes - 1), max_gap);
+
+  if (h->chunk_index < h->chunks.size()) {
+    *address_ret = h->chunks[h->chunk_index].first;
+    *len_ret = h->chunks[h->chunk_index].second;
+    h->chunk_index++;
     return 1;
   } else {
     return 0;
   }
 }
 
-extern "C" char read_section(long long address, const svOpenArrayHandle buffer, long long len)
+// Copy the data of a chunk and set a nonzero strobe for each byte backed by a section
+extern "C" char elf_read_chunk(int handle, long long address, const svOpenArrayHandle buffer,
+                               const svOpenArrayHandle strobes, long long len)
+{
+  char *buf = (char *) svGetArrayPtr(buffer);
+  char *strb = (char *) svGetArrayPtr(strobes);
+  elf_handle_t *h = get_handle(handle);
+  if (!h) return -1;
+
+  uint64_t begin = address, end = address + len;
+  memset(buf, 0, len);
+  memset(strb, 0, len);
+
+  // Start at the last section beginning at or before the chunk
+  std::map<uint64_t, std::pair<const uint8_t *, uint64_t>>::iterator it = h->image->mems.upper_bound(begin);
+  if (it != h->image->mems.begin()) --it;
+
+  for (; it != h->image->mems.end() && it->first < end; ++it) {
+    uint64_t lo = std::max(begin, it->first);
+    uint64_t hi = std::min(end, it->first + it->second.second);
+    if (lo >= hi) continue;
+    memcpy(buf + (lo - begin), it->second.first + (lo - it->first), hi - lo);
+    memset(strb + (lo - begin), 1, hi - lo);
+  }
+
+  return 0;
+}
+
+// Look up the address and size of a symbol by name
+extern "C" char elf_get_symbol(int handle, const char *name, long long *address_ret, long long *size_ret)
+{
+  elf_handle_t *h = get_handle(handle);
+  if (!h) return -1;
+
+  std::map<std::string, std::pair<uint64_t, uint64_t>>::iterator it = h->image->symbols.find(name);
+  if (it == h->image->symbols.end()) return -1;
+
+  *address_ret = it->second.first;
+  *size_ret = it->second.second;
+  return 0;
+}
+
+extern "C" char elf_read_section(int handle, long long address, const svOpenArrayHandle buffer, long long len)
 {
   // get actual pointer
   char *buf = (char *) svGetArrayPtr(buffer);
+  elf_handle_t *h = get_handle(handle);
+  if (!h) return -1;
   
   // check that the address points to a section
-  if (!mems.count(address)) {
+  if (!h->image->mems.count(address)) {
     printf("[ELF] ERROR: No section found for address %p\n", address);
     return -1;
   }
   
-  // copy array
-  long long int len_tmp = len;
-  for (auto &datum : mems.find(address)->second) {
-    if(len_tmp-- == 0){
-      printf("[ELF] ERROR: Copied 0x%lx bytes. Buffer is full but there is still data available.\n", len);
-      return -1;
-    }
-
-    *buf++ = datum;
+  // copy array straight from the file mapping
+  const std::pair<const uint8_t *, uint64_t> &mem = h->image->mems.find(address)->second;
+  if (mem.second > (uint64_t) len) {
+    printf("[ELF] ERROR: Copied 0x%lx bytes. Buffer is full but there is still data available.\n", len);
+    return -1;
   }
 
+  memcpy(buf, mem.first, mem.second);
+
   return 0;
 }
 
+// Parse the headers and symbol table of an ELF file into `image`.
+// Returns 0 on success and -1 if the file is malformed.
 template <class E, class P, class Sh, class Sy>
-static void load_elf(char *buf, size_t size)
+static int load_elf(elf_image_t &image, char *buf, size_t size)
 {
   E  *eh = (E *)   buf;
   P  *ph = (P *)  (buf + eh->e_phoff);
@@ -223,11 +418,11 @@ static void load_elf(char *buf, size_t size)
 
   if(size < eh->e_phoff + (eh->e_phnum * sizeof(P))){
     printf("[ELF] ERROR: Filesize is smaller than advertised program headers (0x%lx vs 0x%lx)\n", size, eh->e_phoff + (eh->e_phnum * sizeof(P)));
-    return;
+    return -1;
   }
 
-  entry = eh->e_entry;
-  printf("[ELF] INFO: Entrypoint at %p\n", entry);
+  image.entry = eh->e_entry;
+  printf("[ELF] INFO: Entrypoint at %p\n", image.entry);
 
   // Iterate over all program header entries
   for (unsigned int i = 0; i < eh->e_phnum; i++) {
@@ -235,14 +430,20 @@ static void load_elf(char *buf, size_t size)
     if(ph[i].p_type == PT_LOAD && ph[i].p_memsz) {
       // Is this section something else than zeros?
       if (ph[i].p_filesz) {
-        assert(size >= ph[i].p_offset + ph[i].p_filesz);
-        sections.push_back(std::make_pair(ph[i].p_paddr, ph[i].p_memsz));
-        write(ph[i].p_paddr, ph[i].p_filesz, (uint8_t*)buf + ph[i].p_offset);
+        if(size < ph[i].p_offset + ph[i].p_filesz){
+          printf("[ELF] ERROR: Filesize is smaller than advertised segment (0x%lx vs 0x%lx)\n",
+                 size, ph[i].p_offset + ph[i].p_filesz);
+          return -1;
+        }
+        image.sections.push_back(std::make_pair(ph[i].p_paddr, ph[i].p_filesz));
+        write(image, ph[i].p_paddr, ph[i].p_filesz, (const uint8_t*)buf + ph[i].p_offset);
       }
 
+      // The remainder of the section is zero-initialized; the preloader must clear it
       if(ph[i].p_memsz > ph[i].p_filesz){
-        printf("[ELF] WARNING: The section starting @ %p contains 0x%lx zero bytes which will NOT be preloaded!\n",
+        printf("[ELF] INFO: The section starting @ %p contains 0x%lx zero bytes to be cleared\n",
                ph[i].p_paddr, (ph[i].p_memsz - ph[i].p_filesz));
+        image.zero_fills.push_back(std::make_pair(ph[i].p_paddr + ph[i].p_filesz, ph[i].p_memsz - ph[i].p_filesz));
       }
     }
   }
@@ -250,19 +451,19 @@ static void load_elf(char *buf, size_t size)
   if(size < eh->e_shoff + (eh->e_shnum * sizeof(Sh))){
     printf("[ELF] ERROR: Filesize is smaller than advertised section headers (0x%lx vs 0x%lx)\n",
            size, eh->e_shoff + (eh->e_shnum * sizeof(Sh)));
-    return;
+    return -1;
   }
 
   if(eh->e_shstrndx >= eh->e_shnum){
     printf("[ELF] ERROR: Malformed ELF file. The index of the section header strings is out of bounds (0x%lx vs max 0x%lx)",
            eh->e_shstrndx, eh->e_shnum);
-    return;
+    return -1;
   }
   
   if(size < sh[eh->e_shstrndx].sh_offset + sh[eh->e_shstrndx].sh_size){
     printf("[ELF] ERROR: Filesize is smaller than advertised size of section name table (0x%lx vs 0x%lx)\n",
            size, sh[eh->e_shstrndx].sh_offset + sh[eh->e_shstrndx].sh_size);
-    return;
+    return -1;
   }
 
   // Get a direct pointer to the section name section
@@ -288,17 +489,88 @@ static void load_elf(char *buf, size_t size)
       continue;
     }
   }
+
+  if(!strtabidx || !symtabidx){
+    printf("[ELF] WARNING: No symbol table found; symbol lookups will fail\n");
+    return 0;
+  }
+
+  if(size < sh[strtabidx].sh_offset + sh[strtabidx].sh_size ||
+     size < sh[symtabidx].sh_offset + sh[symtabidx].sh_size){
+    printf("[ELF] ERROR: Filesize is smaller than advertised size of symbol or string table\n");
+    return -1;
+  }
+
+  // Record all named symbols; global bindings take precedence over local ones
+  char *strtab = buf + sh[strtabidx].sh_offset;
+  Sy *sym = (Sy *) (buf + sh[symtabidx].sh_offset);
+  for (unsigned int i = 0; i < sh[symtabidx].sh_size / sizeof(Sy); i++) {
+    if (!sym[i].st_name || sym[i].st_name >= sh[strtabidx].sh_size) continue;
+    std::string name(strtab + sym[i].st_name,
+                     strnlen(strtab + sym[i].st_name, sh[strtabidx].sh_size - sym[i].st_name));
+    if (image.symbols.count(name) && (sym[i].st_info >> 4) != STB_GLOBAL) continue;
+    image.symbols[name] = std::make_pair(sym[i].st_value, sym[i].st_size);
+  }
+
+  return 0;
+}
+
+// Allocate a new handle for an image, reusing closed handle slots
+static int new_handle(elf_image_t *image)
+{
+  elf_handle_t h;
+  h.image = image;
+  h.section_index = 0;
+  h.zero_fill_index = 0;
+  h.chunk_index = 0;
+  image->refs++;
+  for (size_t i = 0; i < handles.size(); i++) {
+    if (!handles[i].image) {
+      handles[i] = h;
+      return i;
+    }
+  }
+  handles.push_back(h);
+  return handles.size() - 1;
 }
 
-extern "C" char read_elf(const char *filename)
+// Open an ELF file and return a handle with fresh iterators to its image.
+// Images are cached in this process by path and reused while the file's mtime and size are
+// unchanged; separate simulator invocations parse the file again.
+extern "C" char elf_open(const char *filename, int *handle_ret)
 {
   char *buf = NULL;
   Elf64_Ehdr* eh64 = NULL;
-  int fd = open(filename, O_RDONLY);
+  elf_image_t *image = NULL;
+  std::map<std::string, elf_image_t *>::iterator it;
+  int fd = -1;
   char retval = 0;
   struct stat s;
   size_t size = 0;
 
+  if(stat(filename, &s) < 0) {
+    printf("[ELF] ERROR: Unable to read stats for file %s\n", filename);
+    retval = -1;
+    goto exit;
+  }
+
+  // Reuse the cached image if the file did not change; otherwise evict it
+  it = images.find(filename);
+  if (it != images.end()) {
+    image = it->second;
+    if (image->fsize == s.st_size && image->mtime.tv_sec == s.st_mtim.tv_sec &&
+        image->mtime.tv_nsec == s.st_mtim.tv_nsec) {
+      printf("[ELF] INFO: Reusing cached image of file %s\n", filename);
+      *handle_ret = new_handle(image);
+      goto exit;
+    }
+    images.erase(it);
+    image->cached = false;
+    if (image->refs == 0) free_image(image);
+    image = NULL;
+  }
+
+  fd = open(filename, O_RDONLY);
   if(fd == -1){
     printf("[ELF] ERROR: Unable to open file %s\n", filename);
     retval = -1;
@@ -328,6 +600,9 @@ extern "C" char read_elf(const char *filename)
 
   printf("[ELF] INFO: File %s was memory mapped to %p\n", filename, buf);
 
+  // Sections are served from the mapping, so we will read all of it soon
+  madvise(buf, size, MADV_WILLNEED);
+
   eh64 = (Elf64_Ehdr *) buf;
 
   if(!(IS_ELF32(*eh64) || IS_ELF64(*eh64))){
@@ -336,12 +611,34 @@ extern "C" char read_elf(const char *filename)
     goto exit_mmap;
   }
 
+  // The image keeps the mapping alive: sections are served directly from it
+  image = new elf_image_t();
+  image->path = filename;
+  image->mtime = s.st_mtim;
+  image->fsize = s.st_size;
+  image->buf = buf;
+  image->size = size;
+  image->entry = 0;
+  image->refs = 0;
+  image->cached = true;
+
   if (IS_ELF32(*eh64)){
-    load_elf<Elf32_Ehdr, Elf32_Phdr, Elf32_Shdr, Elf32_Sym>(buf, size);
+    retval = load_elf<Elf32_Ehdr, Elf32_Phdr, Elf32_Shdr, Elf32_Sym>(*image, buf, size);
   } else {
-    load_elf<Elf64_Ehdr, Elf64_Phdr, Elf64_Shdr, Elf64_Sym>(buf, size);
+    retval = load_elf<Elf64_Ehdr, Elf64_Phdr, Elf64_Shdr, Elf64_Sym>(*image, buf, size);
+  }
+
+  // Do not cache or hand out partially parsed images; this also releases the mapping
+  if (retval) {
+    printf("[ELF] ERROR: Unable to parse file %s\n", filename);
+    free_image(image);
+    goto exit_fd;
   }
 
+  images[image->path] = image;
+  *handle_ret = new_handle(image);
+  goto exit_fd;
+
 exit_mmap:
   munmap(buf, size);
 
@@ -13,10 +13,12 @@ module tb_cheshire_soc #(
   fixture_cheshire_soc #(.SelectedCfg(SelectedCfg)) fix();
 
   string      preload_elf;
+  string      extra_elfs;
   string      boot_hex;
   logic [1:0] boot_mode;
   logic [1:0] preload_mode;
   bit [31:0]  exit_code;
+  bit [63:0]  tohost;
 
   initial begin
     // Fetch plusargs or use safe (fail-fast) defaults
@@ -24,6 +26,15 @@ module tb_cheshire_soc #(
     if (!$value$plusargs("PRELMODE=%d", preload_mode))  preload_mode  = 0;
     if (!$value$plusargs("BINARY=%s",   preload_elf))   preload_elf   = "";
     if (!$value$plusargs("IMAGE=%s",    boot_hex))      boot_hex      = "";
+    if (!$value$plusargs("EXTRABINS=%s", extra_elfs))   extra_elfs    = "";
+
+    // Register comma-separated additional ELFs to preload before the binary
+    for (int i = 0, s = 0; i <= extra_elfs.len(); ++i) begin
+      if (i == extra_elfs.len() || extra_elfs[i] == ",") begin
+        if (i > s) fix.vip.add_extra_elf(extra_elfs.substr(s, i-1));
+        s = i + 1;
+      end
+    end
 
     // Set boot mode and preload boot image if there is one
     fix.vip.set_boot_mode(boot_mode);
@@ -40,12 +51,24 @@ module tb_cheshire_soc #(
         0: begin      // JTAG
           fix.vip.jtag_init();
           fix.vip.jtag_elf_run(preload_elf);
-          fix.vip.jtag_wait_for_eoc(exit_code);
+          if (fix.vip.elf_find_dram_symbol(preload_elf, "tohost", tohost))
+            fix.vip.dram_wait_for_eoc(tohost, 0, exit_code);
+          else
+            fix.vip.jtag_wait_for_eoc(exit_code);
         end 1: begin  // Serial Link
           fix.vip.slink_elf_run(preload_elf);
-          fix.vip.slink_wait_for_eoc(exit_code);
+          if (fix.vip.elf_find_dram_symbol(preload_elf, "tohost", tohost))
+            fix.vip.dram_wait_for_eoc(tohost, 1, exit_code);
+          else
+            fix.vip.slink_wait_for_eoc(exit_code);
         end 2: begin  // UART
           fix.vip.uart_debug_elf_run_and_wait(preload_elf, exit_code);
+        end 3: begin  // DRAM backdoor, Serial Link for remaining sections and launch
+          fix.vip.slink_elf_run(preload_elf, 1);
+          if (fix.vip.elf_find_dram_symbol(preload_elf, "tohost", tohost))
+            fix.vip.dram_wait_for_eoc(tohost, 1, exit_code);
+          else
+            fix.vip.slink_wait_for_eoc(exit_code);
         end default: begin
           $fatal(1, "Unsupported preload mode %d (reserved)!", boot_mode);
         end
@@ -58,6 +81,10 @@ module tb_cheshire_soc #(
       fix.vip.jtag_wait_for_eoc(exit_code);
     end
 
+    // Dump the boot-stage trace; JTAG is not yet initialized in non-JTAG preload modes
+    if (boot_mode == 0 && preload_mode != 0) fix.vip.jtag_init();
+    fix.vip.jtag_boot_trace_dump();
+
     // Wait for the UART to finish reading the current byte
     wait (fix.vip.uart_reading_byte == 0);
 
@@ -23,19 +23,30 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
   parameter int unsigned  RstCycles         = 5,
   parameter real          TAppl             = 0.1,
   parameter real          TTest             = 0.9,
+  // JTAG
+  parameter int unsigned  JtagStreamBytes   = 4096,
   // UART
   parameter int unsigned  UartBaudRate      = 115200,
+  parameter int unsigned  UartDebugBaudRate = 0,
   parameter int unsigned  UartParityEna     = 0,
   parameter int unsigned  UartBurstBytes    = 256,
+  parameter int unsigned  UartBlockBytes    = 4096,
+  parameter bit           UartLzEna         = 0,
+  parameter int unsigned  UartWinBlocks     = 0,
   parameter int unsigned  UartWaitCycles    = 60,
   // Serial Link
   parameter int unsigned  SlinkMaxWaitAx    = 100,
   parameter int unsigned  SlinkMaxWaitR     = 5,
   parameter int unsigned  SlinkMaxWaitResp  = 20,
   parameter int unsigned  SlinkBurstBytes   = 1024,
+  parameter int unsigned  SlinkMaxGapBytes  = 256,
   parameter int unsigned  SlinkMaxTxns      = 32,
   parameter int unsigned  SlinkMaxTxnsPerId = 16,
   parameter bit           SlinkAxiDebug     = 0,
+  // Boot trace (must match `__BOOT_TRACE` in `sw/include/params.h`)
+  parameter doub_bt       BootTraceAddr     = 'h1000_E080,
+  // Cycles between fallback polls of `scratch[2]` while watching DRAM for termination
+  parameter int unsigned  DramEocPollCycles = 20000,
   // Derived Parameters;  *do not override*
   parameter int unsigned  AxiStrbWidth      = DutCfg.AxiDataWidth/8,
   parameter int unsigned  AxiStrbBits       = $clog2(DutCfg.AxiDataWidth/8)
@@ -83,10 +94,23 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
   //  DPI  //
   ///////////
 
-  import "DPI-C" function byte read_elf(input string filename);
-  import "DPI-C" function byte get_entry(output longint entry);
-  import "DPI-C" function byte get_section(output longint address, output longint len);
-  import "DPI-C" context function byte read_section(input longint address, inout byte buffer[], input longint len);
+  import "DPI-C" function byte elf_open(input string filename, output int handle);
+  import "DPI-C" function byte elf_close(input int handle);
+  import "DPI-C" function byte elf_rewind(input int handle);
+  import "DPI-C" function byte elf_get_entry(input int handle, output longint entry);
+  import "DPI-C" function byte elf_get_section(input int handle, output longint address, output longint len);
+  import "DPI-C" function byte elf_get_zero_fill(input int handle, output longint address, output longint len);
+  import "DPI-C" context function byte elf_read_section(input int handle, input longint address, inout byte buffer[], input longint len);
+  import "DPI-C" function byte elf_get_symbol(input int handle, input string name, output longint address, output longint size);
+  import "DPI-C" function byte elf_get_chunk(input int handle, input longint bus_bytes, input longint max_bytes, input longint max_gap, output longint address, output longint len);
+  import "DPI-C" context function byte elf_read_chunk(input int handle, input longint address, inout byte buffer[], inout byte strobes[], input longint len);
+
+  // Additional ELF images (e.g. payloads or data) preloaded before the main binary
+  string elf_extra_images [$];
+
+  function automatic void add_extra_elf(input string binary);
+    elf_extra_images.push_back(binary);
+  endfunction
 
   ////////////
   //  DRAM  //
@@ -124,6 +148,91 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     .mon_r_last_o       ( )
   );
 
+  // Zero a range directly in the DRAM model. Returns 0 if the range is not fully in DRAM.
+  // This is only safe while no cache holds DRAM lines, i.e. before the preloaded code runs.
+  function automatic bit dram_backdoor_zero_fill(input doub_bt addr, input doub_bt len);
+    if (addr < DutCfg.LlcOutRegionStart || addr + len > DutCfg.LlcOutRegionEnd) return 0;
+    for (doub_bt i = 0; i < len; ++i)
+      i_dram_sim_mem.mem[addr + i] = '0;
+    return 1;
+  endfunction
+
+  // Write the strobed bytes of a buffer directly into the DRAM model. Returns 0 if the
+  // range is not fully in DRAM. The same caveat as for zero-filling applies.
+  function automatic bit dram_backdoor_write(input doub_bt addr, input doub_bt len,
+                                             ref byte data [], ref byte strb []);
+    if (addr < DutCfg.LlcOutRegionStart || addr + len > DutCfg.LlcOutRegionEnd) return 0;
+    for (doub_bt i = 0; i < len; ++i)
+      if (strb[i][0]) i_dram_sim_mem.mem[addr + i] = data[i];
+    return 1;
+  endfunction
+
+  function automatic word_bt dram_backdoor_read_32(input doub_bt addr);
+    word_bt ret;
+    for (int i = 0; i < 4; ++i)
+      ret[8*i +: 8] = i_dram_sim_mem.mem.exists(addr + i) ? i_dram_sim_mem.mem[addr + i] : '0;
+    return ret;
+  endfunction
+
+  // Find a symbol of a binary that resides in DRAM; returns 0 if there is no such symbol.
+  function automatic bit elf_find_dram_symbol(input string binary, input string name,
+                                              output doub_bt addr);
+    int elf;
+    longint sym_addr, sym_size;
+    bit found;
+    if (elf_open(binary, elf)) return 0;
+    found = !elf_get_symbol(elf, name, sym_addr, sym_size) && sym_size >= 4 &&
+        sym_addr >= DutCfg.LlcOutRegionStart && sym_addr + 4 <= DutCfg.LlcOutRegionEnd;
+    void'(elf_close(elf));
+    addr = sym_addr;
+    return found;
+  endfunction
+
+  // Wait for termination signal and get return code by watching the (`tohost`) word
+  // at `addr` in the DRAM model. Unlike polling through a debug interface, this needs no
+  // bus traffic and notices termination within a cycle of it reaching DRAM. `_exit` writes
+  // `tohost` back through all caches, but it is never written if the program does not return
+  // from `main` (e.g. a trap handler only setting `scratch[2]`). We thus also poll `scratch[2]`
+  // every `DramEocPollCycles` through JTAG or, if `via_slink` is set, the serial link, and
+  // finish on whichever signals first.
+  task automatic dram_wait_for_eoc(input doub_bt addr, input bit via_slink,
+                                   output word_bt exit_code);
+    doub_bt scratch_addr = AmRegs + cheshire_reg_pkg::CHESHIRE_SCRATCH_2_OFFSET;
+    word_bt dram_code = '0, reg_code = '0;
+    bit done = 0;
+    fork
+      begin
+        do begin
+          @(posedge clk);
+          dram_code = dram_backdoor_read_32(addr);
+        end while (~dram_code[0] & ~done);
+        done = 1;
+      end
+      // Only stop polling between accesses so the interface is left idle
+      begin
+        do begin
+          repeat (DramEocPollCycles) begin
+            @(posedge clk);
+            if (done) break;
+          end
+          if (done) break;
+          if (via_slink) begin
+            axi_data_t beats [$];
+            slink_read_beats(scratch_addr, 2, 0, beats);
+            reg_code = beats[0] >> scratch_addr[AxiStrbBits-1:0];
+          end else begin
+            jtag_read_reg32(scratch_addr, reg_code, 20, 1);
+          end
+        end while (~reg_code[0]);
+        done = 1;
+      end
+    join
+    exit_code = dram_code[0] ? dram_code : reg_code;
+    exit_code >>= 1;
+    if (exit_code) $error("[DRAM] FAILED: return code %0d", exit_code);
+    else $display("[DRAM] SUCCESS");
+  endtask
+
   ///////////////////////////////
   //  SoC Clock, Reset, Modes  //
   ///////////////////////////////
@@ -260,7 +369,8 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
   task automatic jtag_read_reg32(
     input doub_bt addr,
     output word_bt data,
-    input int unsigned idle_cycles = 20
+    input int unsigned idle_cycles = 20,
+    input bit quiet = 0
   );
     automatic dm::sbcs_t sbcs = dm::sbcs_t'{sbreadonaddr: 1'b1, sbaccess: 2, default: '0};
     jtag_write(dm::SBCS, sbcs, 0, 1);
@@ -268,7 +378,7 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     jtag_write(dm::SBAddress0, addr[31:0]);
     jtag_dbg.wait_idle(idle_cycles);
     jtag_dbg.read_dmi_exp_backoff(dm::SBData0, data);
-    $display("[JTAG] Read 0x%h from 0x%h", data, addr);
+    if (!quiet) $display("[JTAG] Read 0x%h from 0x%h", data, addr);
   endtask
 
   task automatic jtag_write_reg32(
@@ -292,29 +402,118 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     end
   endtask
 
+  // Write a single byte through the system bus. As later block checks would not resend
+  // it, we wait for the write to complete and fail on errors.
+  task automatic jtag_sba_write_8(input doub_bt addr, input byte_bt data);
+    jtag_write(dm::SBCS, dm::sbcs_t'{sbaccess: 0, default: '0}, 0, 1);
+    jtag_write(dm::SBAddress1, addr[63:32]);
+    jtag_write(dm::SBAddress0, addr[31:0]);
+    jtag_write(dm::SBData0, data, 1, 1);
+  endtask
+
+  // Check the system bus status once; sticky errors are cleared if present
+  task automatic jtag_sba_check(output bit ok);
+    dm::sbcs_t sbcs;
+    do jtag_dbg.read_dmi_exp_backoff(dm::SBCS, sbcs);
+    while (sbcs.sbbusy);
+    ok = ~(|sbcs.sberror | sbcs.sbbusyerror);
+    if (!ok) jtag_dbg.write_dmi(dm::SBCS, dm::sbcs_t'{sbbusyerror: 1'b1, sberror: '1, default: '0});
+  endtask
+
+  // Send words with autoincrementing 64-bit accesses, writing SBData1 only when it changes.
+  // With `poll` set, we wait for the bus every 512 bytes and fail on errors.
+  task automatic jtag_sba_send_64(input doub_bt addr, ref doub_bt words [$],
+                                  input int first, input int num, input bit poll);
+    jtag_write(dm::SBCS, JtagInitSbcs, 1, 1);
+    jtag_write(dm::SBAddress1, addr[63:32]);
+    jtag_write(dm::SBAddress0, addr[31:0]);
+    for (int i = first; i < first + num; ++i) begin
+      bit checkpoint = poll && ((i - first) % 64 == 63 || i == first + num - 1);
+      if (i == first || words[i][63:32] != words[i-1][63:32])
+        jtag_write(dm::SBData1, words[i][63:32]);
+      jtag_write(dm::SBData0, words[i][31:0], checkpoint, checkpoint);
+    end
+  endtask
+
+  // Write consecutive 64-bit words. If `JtagStreamBytes` is nonzero, blocks of that size
+  // are streamed at the DMI scan rate without polling, and the bus status is checked only
+  // once per block; a block which failed (e.g. as the bus was still busy) is resent with
+  // polling. Otherwise, all words are sent with polling.
+  task automatic jtag_sba_write_64(input doub_bt addr, ref doub_bt words [$]);
+    int blk_words = JtagStreamBytes ? JtagStreamBytes / 8 : words.size();
+    for (int b = 0; b < words.size(); b += blk_words) begin
+      int num = (words.size() - b < blk_words) ? words.size() - b : blk_words;
+      bit ok = 0;
+      if (JtagStreamBytes) begin
+        jtag_sba_send_64(addr + 8*b, words, b, num, 0);
+        jtag_sba_check(ok);
+        if (!ok) $display("[JTAG] - Bus busy or error at 0x%h, resending block", addr + 8*b);
+      end
+      if (!ok) jtag_sba_send_64(addr + 8*b, words, b, num, 1);
+    end
+  endtask
+
+  // Zero a range; the aligned body is written with autoincrementing 64-bit accesses, for
+  // which a write of SBData0 alone suffices as SBData1 keeps its zero value.
+  task automatic jtag_zero_fill(input doub_bt addr, input doub_bt len);
+    doub_bt end_addr  = addr + len;
+    doub_bt body_addr = (addr + 7) & ~doub_bt'(7);
+    doub_bt body_end  = end_addr & ~doub_bt'(7);
+    if (dram_backdoor_zero_fill(addr, len)) return;
+    if (body_addr >= body_end) begin
+      body_addr = end_addr;
+      body_end  = end_addr;
+    end
+    // Clear unaligned leading and trailing bytes individually
+    for (doub_bt a = (addr == body_addr) ? body_end : addr; a < end_addr;
+         a = (a + 1 == body_addr) ? body_end : a + 1)
+      jtag_sba_write_8(a, '0);
+    if (body_addr != body_end) begin
+      doub_bt words [$];
+      for (doub_bt a = body_addr; a < body_end; a += 8) words.push_back('0);
+      jtag_sba_write_64(body_addr, words);
+    end
+  endtask
+
   // Load a binary
   task automatic jtag_elf_preload(input string binary, output doub_bt entry);
     longint sec_addr, sec_len;
+    int elf;
     $display("[JTAG] Preloading ELF binary: %s", binary);
-    if (read_elf(binary))
+    if (elf_open(binary, elf))
       $fatal(1, "[JTAG] Failed to load ELF!");
-    while (get_section(sec_addr, sec_len)) begin
+    // Write aligned chunks of section data; words only partially covered by sections
+    // are written bytewise, runs of all others with autoincrementing 64-bit accesses.
+    while (elf_get_chunk(elf, 8, 'h1000, 0, sec_addr, sec_len)) begin
       byte bf[] = new [sec_len];
-      $display("[JTAG] Preloading section at 0x%h (%0d bytes)", sec_addr, sec_len);
-      if (read_section(sec_addr, bf, sec_len)) $fatal(1, "[JTAG] Failed to read ELF section!");
-      jtag_write(dm::SBCS, JtagInitSbcs, 1, 1);
-      // Write address as 64-bit double
-      jtag_write(dm::SBAddress1, sec_addr[63:32]);
-      jtag_write(dm::SBAddress0, sec_addr[31:0]);
-      for (longint i = 0; i <= sec_len ; i += 8) begin
-        bit checkpoint = (i != 0 && i % 512 == 0);
-        if (checkpoint)
-          $display("[JTAG] - %0d/%0d bytes (%0d%%)", i, sec_len, i*100/(sec_len>1 ? sec_len-1 : 1));
-        jtag_write(dm::SBData1, {bf[i+7], bf[i+6], bf[i+5], bf[i+4]});
-        jtag_write(dm::SBData0, {bf[i+3], bf[i+2], bf[i+1], bf[i]}, checkpoint, checkpoint);
+      byte bs[] = new [sec_len];
+      doub_bt run [$];
+      doub_bt run_addr;
+      if (elf_read_chunk(elf, sec_addr, bf, bs, sec_len))
+        $fatal(1, "[JTAG] Failed to read ELF chunk!");
+      if (sec_addr % 'h10000 == 0) $display("[JTAG] - Preloading at 0x%h", sec_addr);
+      for (longint i = 0; i < sec_len; i += 8) begin
+        doub_bt addr = sec_addr + i;
+        bit [7:0] strb;
+        for (int e = 0; e < 8; ++e) strb[e] = bs[i+e][0];
+        if (&strb) begin
+          if (run.size() == 0) run_addr = addr;
+          run.push_back({bf[i+7], bf[i+6], bf[i+5], bf[i+4], bf[i+3], bf[i+2], bf[i+1], bf[i]});
+        end else begin
+          if (run.size() != 0) jtag_sba_write_64(run_addr, run);
+          run.delete();
+          for (int e = 0; e < 8; ++e)
+            if (strb[e]) jtag_sba_write_8(addr + e, bf[i+e]);
+        end
       end
+      if (run.size() != 0) jtag_sba_write_64(run_addr, run);
+    end
+    while (elf_get_zero_fill(elf, sec_addr, sec_len)) begin
+      $display("[JTAG] Clearing range at 0x%h (%0d bytes)", sec_addr, sec_len);
+      jtag_zero_fill(sec_addr, sec_len);
     end
-    void'(get_entry(entry));
+    void'(elf_get_entry(elf, entry));
+    void'(elf_close(elf));
     $display("[JTAG] Preload complete");
   endtask
 
@@ -332,7 +531,11 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     do jtag_dbg.read_dmi_exp_backoff(dm::DMStatus, status);
     while (~status.allhalted);
     $display("[JTAG] Halted hart 0");
-    // Preload binary
+    // Preload additional images, then binary
+    foreach (elf_extra_images[i]) begin
+      doub_bt extra_entry;
+      jtag_elf_preload(elf_extra_images[i], extra_entry);
+    end
     jtag_elf_preload(binary, entry);
   endtask
 
@@ -357,6 +560,36 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     else $display("[JTAG] SUCCESS");
   endtask
 
+  localparam word_bt      BootTraceMagic   = 'h4352_5442;
+  localparam int unsigned BootTraceMaxRecs = 20;
+
+  // Read a 64-bit word as two 32-bit system bus reads
+  task automatic jtag_read_64_quiet(input doub_bt addr, output doub_bt data);
+    word_bt lo, hi;
+    jtag_read_reg32(addr, lo, 20, 1);
+    jtag_read_reg32(addr + 4, hi, 20, 1);
+    data = {hi, lo};
+  endtask
+
+  // Dump the boot-stage trace left in SPM by the boot ROM and ZSL (see `boottrace.h`)
+  task automatic jtag_boot_trace_dump;
+    word_bt magic, count, stage;
+    doub_bt rec, mcycle, mtime;
+    jtag_read_reg32(BootTraceAddr, magic, 20, 1);
+    if (magic != BootTraceMagic) begin
+      $display("[TRACE] No boot trace found");
+      return;
+    end
+    jtag_read_reg32(BootTraceAddr + 4, count, 20, 1);
+    for (int i = 0; i < count && i < BootTraceMaxRecs; ++i) begin
+      rec = BootTraceAddr + 8 + 24 * i;
+      jtag_read_reg32(rec, stage, 20, 1);
+      jtag_read_64_quiet(rec + 8, mcycle);
+      jtag_read_64_quiet(rec + 16, mtime);
+      $display("[TRACE] Stage %0d: mcycle %0d, mtime %0d", stage, mcycle, mtime);
+    end
+  endtask
+
   ////////////
   //  UART  //
   ////////////
@@ -366,14 +599,20 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
   localparam byte_bt UartDebugCmdRead  = 'h11;
   localparam byte_bt UartDebugCmdWrite = 'h12;
   localparam byte_bt UartDebugCmdExec  = 'h13;
+  localparam byte_bt UartDebugCmdWrLz  = 'h15;
+  localparam byte_bt UartDebugCmdWrWin = 'h16;
+  localparam byte_bt UartDebugCmdSetBd = 'h17;
   localparam byte_bt UartDebugAck      = 'h06;
   localparam byte_bt UartDebugEot      = 'h04;
   localparam byte_bt UartDebugEoc      = 'h14;
+  localparam byte_bt UartDebugNak      = 'h18;
+  localparam byte_bt UartDebugSoh      = 'h01;
 
   byte_bt uart_boot_byte;
   logic   uart_boot_ena;
   logic   uart_boot_eoc;
   logic   uart_reading_byte;
+  time    uart_baud_period = UartBaudPeriod;
 
   initial begin
     uart_rx           = 1;
@@ -386,20 +625,20 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     // Start bit
     @(negedge uart_tx);
     uart_reading_byte = 1;
-    #(UartBaudPeriod/2);
+    #(uart_baud_period/2);
     // 8-bit byte
     for (int i = 0; i < 8; i++) begin
-      #UartBaudPeriod bite[i] = uart_tx;
+      #uart_baud_period bite[i] = uart_tx;
     end
     // Parity bit
     if(UartParityEna) begin
       bit parity;
-      #UartBaudPeriod parity = uart_tx;
+      #uart_baud_period parity = uart_tx;
       if(parity ^ (^bite))
         $error("[UART] - Parity error detected!");
     end
     // Stop bit
-    #UartBaudPeriod;
+    #uart_baud_period;
     uart_reading_byte=0;
   endtask
 
@@ -408,13 +647,13 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     uart_rx = 1'b0;
     // 8-bit byte
     for (int i = 0; i < 8; i++)
-      #UartBaudPeriod uart_rx = bite[i];
+      #uart_baud_period uart_rx = bite[i];
     // Parity bit
     if (UartParityEna)
-      #UartBaudPeriod uart_rx = (^bite);
+      #uart_baud_period uart_rx = (^bite);
     // Stop bit
-    #UartBaudPeriod uart_rx = 1'b1;
-    #UartBaudPeriod;
+    #uart_baud_period uart_rx = 1'b1;
+    #uart_baud_period;
   endtask
 
   task automatic uart_boot_scoop(output byte_bt bite);
@@ -480,32 +719,198 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     uart_boot_scoop_expect("EOT", UartDebugEot);
   endtask
 
+  // Compress data into the LZ token format of the debug server's WRITELZ command. We greedily
+  // take the most recent match for each 3-byte prefix, which captures runs and repeated code.
+  function automatic void uart_debug_lz_compress(ref byte_bt src [$], ref byte_bt dst [$]);
+    int last [int];
+    int lit = 0, i = 0;
+    dst.delete();
+    while (i <= src.size()) begin
+      int len = 0, off = 0;
+      if (i + 3 <= src.size()) begin
+        int key = {src[i], src[i+1], src[i+2]};
+        if (last.exists(key) && i - last[key] < 'h10000) begin
+          off = i - last[key];
+          while (len < 130 && i + len < src.size() && src[i+len-off] == src[i+len]) len++;
+        end
+        last[key] = i;
+      end
+      // Emit pending literals before a match or at the end
+      if (len >= 3 || i == src.size()) begin
+        for (int l = lit; l < i; l += 128) begin
+          int num = (i - l < 128) ? i - l : 128;
+          dst.push_back(num - 1);
+          for (int k = 0; k < num; ++k) dst.push_back(src[l+k]);
+        end
+      end
+      if (i == src.size()) break;
+      if (len >= 3) begin
+        dst.push_back('h80 | (len - 3));
+        dst.push_back(off[7:0]);
+        dst.push_back(off[15:8]);
+        i  += len;
+        lit = i;
+      end else begin
+        i++;
+      end
+    end
+  endfunction
+
+  // CRC32 (IEEE 802.3) update as used by the WRITEWIN command
+  function automatic word_bt uart_debug_crc32(input word_bt crc, ref byte_bt data [$]);
+    foreach (data[i]) begin
+      crc ^= data[i];
+      for (int b = 0; b < 8; ++b) crc = (crc >> 1) ^ (crc[0] ? 32'hEDB88320 : '0);
+    end
+    return crc;
+  endfunction
+
+  // Write data using the WRITEWIN command. Frames of `UartBurstBytes` are streamed up to
+  // `UartWinBlocks` ahead of the last cumulative acknowledge; on a NAK, we rewind. As the
+  // server cannot NAK frames it never saw, we also rewind if acknowledges stall for twice the
+  // time to transfer a full window, e.g. because a retransmitted frame was lost entirely.
+  task automatic uart_debug_write_win(doub_bt addr, ref byte_bt data [$]);
+    doub_bt len = data.size();
+    doub_bt blk = UartBurstBytes;
+    int num = (len + blk - 1) / blk;
+    int base = 0, next = 0, rewinds = 0;
+    time stall = 2 * (UartWinBlocks + 1) * (blk + 9) * 11 * uart_baud_period;
+    time last_progress = $time;
+    uart_write_byte(UartDebugCmdWrWin);
+    for (int i = 0; i < 8; ++i) uart_write_byte(addr[8*i +: 8]);
+    for (int i = 0; i < 8; ++i) uart_write_byte(len[8*i +: 8]);
+    for (int i = 0; i < 8; ++i) uart_write_byte(blk[8*i +: 8]);
+    uart_boot_scoop_expect("ACK", UartDebugAck);
+    fork
+      // Receive cumulative acknowledges and retransmission requests
+      while (base < num) begin
+        byte_bt code;
+        word_bt idx;
+        uart_boot_scoop(code);
+        for (int i = 0; i < 4; ++i) uart_boot_scoop(idx[8*i +: 8]);
+        if (code == UartDebugNak) begin
+          $display("[UART] - Retransmitting from frame %0d", idx);
+          next = idx;
+          rewinds++;
+        end else if (code != UartDebugAck) begin
+          $fatal(1, "[UART] Expected ACK or NAK in windowed write, received %0x", code);
+        end
+        if (idx > base) begin
+          base = idx;
+          last_progress = $time;
+        end
+      end
+      // Stream frames within the window
+      while (base < num) begin
+        if (next < num && next < base + UartWinBlocks) begin
+          byte_bt frame [$];
+          word_bt idx = next;
+          word_bt crc;
+          int rw = rewinds;
+          for (int i = 0; i < 4; ++i) frame.push_back(idx[8*i +: 8]);
+          for (doub_bt i = idx * blk; i < len && i < (idx + 1) * blk; ++i)
+            frame.push_back(data[i]);
+          crc = ~uart_debug_crc32('1, frame);
+          for (int i = 0; i < 4; ++i) frame.push_back(crc[8*i +: 8]);
+          uart_write_byte(UartDebugSoh);
+          foreach (frame[i]) uart_write_byte(frame[i]);
+          if (rw == rewinds) next++;
+        end else if ($time - last_progress > stall) begin
+          $display("[UART] - Acknowledges stalled; retransmitting from frame %0d", base);
+          next = base;
+          rewinds++;
+          last_progress = $time;
+        end else begin
+          #uart_baud_period;
+        end
+      end
+    join
+    uart_boot_scoop_expect("EOT", UartDebugEot);
+  endtask
+
+  // Write data, using the WRITELZ command if enabled and it reduces transferred bytes,
+  // and otherwise the WRITEWIN command if enabled.
+  task automatic uart_debug_write(doub_bt addr, ref byte_bt data [$]);
+    byte_bt lz [$];
+    doub_bt len = data.size();
+    doub_bt clen;
+    if (UartLzEna) uart_debug_lz_compress(data, lz);
+    clen = lz.size();
+    if (!UartLzEna || clen + 8 >= len) begin
+      if (UartWinBlocks) uart_debug_write_win(addr, data);
+      else uart_debug_rw(addr, 0, data);
+      return;
+    end
+    uart_write_byte(UartDebugCmdWrLz);
+    for (int i = 0; i < 8; ++i) uart_write_byte(addr[8*i +: 8]);
+    for (int i = 0; i < 8; ++i) uart_write_byte(len[8*i +: 8]);
+    for (int i = 0; i < 8; ++i) uart_write_byte(clen[8*i +: 8]);
+    uart_boot_scoop_expect("ACK", UartDebugAck);
+    foreach (lz[i]) uart_write_byte(lz[i]);
+    uart_boot_scoop_expect("EOT", UartDebugEot);
+  endtask
+
+  // Write data in blocks of `UartBlockBytes`
+  task automatic uart_debug_write_blocks(input doub_bt addr, ref byte bf [], input doub_bt len,
+                                         input bit verbose);
+    for (longint i = 0; i < len; i += UartBlockBytes) begin
+      byte_bt bytes [$];
+      if (verbose && i != 0) $display("[UART] - %0d/%0d bytes (%0d%%)", i, len, i*100/len);
+      for (int b = 0; b < UartBlockBytes && i+b < len; b++) bytes.push_back(bf[i+b]);
+      uart_debug_write(addr + i, bytes);
+    end
+  endtask
+
+  // Zero a range, sending zero blocks only if it is not in DRAM
+  task automatic uart_debug_zero_fill(input doub_bt addr, input doub_bt len);
+    byte bf [] = new [len];
+    if (dram_backdoor_zero_fill(addr, len)) return;
+    foreach (bf[i]) bf[i] = '0;
+    uart_debug_write_blocks(addr, bf, len, 0);
+  endtask
+
   // Load a binary
   task automatic uart_debug_elf_preload(input string binary, output doub_bt entry);
     longint sec_addr, sec_len;
+    int elf;
     $display("[UART] Preloading ELF binary: %s", binary);
-    if (read_elf(binary))
+    if (elf_open(binary, elf))
       $fatal(1, "[UART] Failed to load ELF!");
-    while (get_section(sec_addr, sec_len)) begin
+    while (elf_get_section(elf, sec_addr, sec_len)) begin
       byte bf[] = new [sec_len];
       $display("[UART] Preloading section at 0x%h (%0d bytes)", sec_addr, sec_len);
-      if (read_section(sec_addr, bf, sec_len)) $fatal(1, "[UART] Failed to read ELF section!");
-      // Write section in blocks
-      for (longint i = 0; i <= sec_len ; i += UartBurstBytes) begin
-        byte_bt bytes [$];
-        if (i != 0)
-          $display("[UART] - %0d/%0d bytes (%0d%%)", i, sec_len, i*100/(sec_len>1 ? sec_len-1 : 1));
-        for (int b = 0; b < UartBurstBytes; b++) begin
-          if (i+b >= sec_len) break;
-          bytes.push_back(bf [i+b]);
-        end
-        uart_debug_rw(sec_addr + i, 0, bytes);
-      end
+      if (elf_read_section(elf, sec_addr, bf, sec_len))
+        $fatal(1, "[UART] Failed to read ELF section!");
+      uart_debug_write_blocks(sec_addr, bf, sec_len, 1);
+    end
+    while (elf_get_zero_fill(elf, sec_addr, sec_len)) begin
+      $display("[UART] Clearing range at 0x%h (%0d bytes)", sec_addr, sec_len);
+      uart_debug_zero_fill(sec_addr, sec_len);
     end
-    void'(get_entry(entry));
+    void'(elf_get_entry(elf, entry));
+    void'(elf_close(elf));
     $display("[UART] Preload complete");
   endtask
 
+  // Switch the debug server and ourselves to a new baud rate if the server accepts it
+  task automatic uart_debug_set_baud(input doub_bt baud, output bit ok);
+    byte_bt bite;
+    time old_period = uart_baud_period;
+    uart_write_byte(UartDebugCmdSetBd);
+    for (int i = 0; i < 8; ++i)
+      uart_write_byte(baud[8*i +: 8]);
+    uart_boot_scoop(bite);
+    ok = (bite == UartDebugAck);
+    if (!ok) return;
+    // Give the server time to reconfigure, then confirm the new rate
+    uart_baud_period = 1000ns*1000*1000/baud;
+    #(2*old_period);
+    uart_write_byte(UartDebugAck);
+    uart_boot_scoop(bite);
+    ok = (bite == UartDebugAck);
+    if (!ok) uart_baud_period = old_period;
+  endtask
+
   task automatic uart_debug_elf_run_and_wait(input string binary, output word_bt exit_code);
     byte_bt bite;
     doub_bt entry;
@@ -516,13 +921,26 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     $display("[UART] Sending ACK chellenge");
     uart_write_byte(UartDebugAck);
     uart_boot_scoop_expect("ACK", UartDebugAck);
-    // Preload
+    // Upgrade the baud rate for preloading if requested
+    if (UartDebugBaudRate != 0 && UartDebugBaudRate != UartBaudRate) begin
+      bit ok;
+      uart_debug_set_baud(UartDebugBaudRate, ok);
+      if (ok) $display("[UART] Switched to %0d baud", UartDebugBaudRate);
+      else $display("[UART] Server rejected %0d baud, staying at %0d", UartDebugBaudRate, UartBaudRate);
+    end
+    // Preload additional images, then binary
+    foreach (elf_extra_images[i]) begin
+      doub_bt extra_entry;
+      uart_debug_elf_preload(elf_extra_images[i], extra_entry);
+    end
     uart_debug_elf_preload(binary, entry);
   $display("[UART] Sending EXEC command for address %0x", entry);
     // Send exec command and receive ACK
     uart_write_byte(UartDebugCmdExec);
     for (int i = 0; i < 8; ++i)
       uart_write_byte(entry[8*i +: 8]);
+    // The server returns to the boot baud rate on EXEC, as invoked code expects it
+    uart_baud_period = UartBaudPeriod;
     uart_boot_scoop_expect("ACK", UartDebugAck);
     // Wait for EOC and read return code
     wait (uart_boot_eoc == 1);
@@ -758,12 +1176,24 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     input addr_t          addr,
     input axi_pkg::size_t size,
     ref axi_data_t        beats [$]
+  );
+    axi_strb_t strbs [$];
+    int size_bytes = (1 << size);
+    for (int i = 0; i < beats.size(); ++i)
+      strbs.push_back(i == 0 ? (~('1 << size_bytes)) << addr[AxiStrbBits-1:0] : '1);
+    slink_write_beats_strb(addr, size, beats, strbs);
+  endtask
+
+  task automatic slink_write_beats_strb(
+    input addr_t          addr,
+    input axi_pkg::size_t size,
+    ref axi_data_t        beats [$],
+    ref axi_strb_t        strbs [$]
   );
     slink_axi_driver_t::ax_beat_t ax = new();
     slink_axi_driver_t::w_beat_t w = new();
     slink_axi_driver_t::b_beat_t b;
     int i = 0;
-    int size_bytes = (1 << size);
     if (beats.size() == 0)
       $fatal(1, "[SLINK] Zero-length write requested!");
     @(posedge clk);
@@ -776,13 +1206,11 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     if (SlinkAxiDebug) $display("[SLINK] - Sending AW ");
     slink_axi_driver.send_aw(ax);
     do begin
-      w.w_strb = i == 0 ? (~('1 << size_bytes)) << addr[AxiStrbBits-1:0] : '1;
+      w.w_strb = strbs[i];
       w.w_data = beats[i];
       w.w_last = (i == ax.ax_len);
       if (SlinkAxiDebug) $display("[SLINK] - Sending W (%0d)", i);
       slink_axi_driver.send_w(w);
-      addr += size_bytes;
-      addr &= size_bytes - 1;
       i++;
     end while (i <= ax.ax_len);
     if (SlinkAxiDebug) $display("[SLINK] - Receiving B");
@@ -842,49 +1270,85 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
     end while (~data[0]);
   endtask
 
-  // Load a binary
-  task automatic slink_elf_preload(input string binary, output doub_bt entry);
-    longint sec_addr, sec_len, bus_offset, write_addr;
+  // Zero a range using maximum-length bursts that do not cross 4 KiB boundaries
+  task automatic slink_zero_fill(input doub_bt addr, input doub_bt len);
+    doub_bt end_addr  = addr + len;
+    doub_bt body_addr = (addr + AxiStrbWidth - 1) & ~doub_bt'(AxiStrbWidth - 1);
+    doub_bt body_end  = end_addr & ~doub_bt'(AxiStrbWidth - 1);
+    if (dram_backdoor_zero_fill(addr, len)) return;
+    if (body_addr >= body_end) begin
+      body_addr = end_addr;
+      body_end  = end_addr;
+    end
+    // Clear unaligned leading and trailing bytes individually
+    for (doub_bt a = (addr == body_addr) ? body_end : addr; a < end_addr;
+         a = (a + 1 == body_addr) ? body_end : a + 1) begin
+      axi_data_t beats [$];
+      beats.push_back('0);
+      slink_write_beats(a, 0, beats);
+    end
+    // Clear aligned body
+    for (doub_bt a = body_addr; a < body_end;) begin
+      axi_data_t beats [$];
+      doub_bt burst_end = (a | 'hFFF) + 1;
+      if (burst_end > body_end) burst_end = body_end;
+      if (burst_end > a + 256 * AxiStrbWidth) burst_end = a + 256 * AxiStrbWidth;
+      for (doub_bt b = a; b < burst_end; b += AxiStrbWidth)
+        beats.push_back('0);
+      slink_write_beats(a, AxiStrbBits, beats);
+      a = burst_end;
+    end
+  endtask
+
+  // Load a binary; with `backdoor` set, chunks in DRAM are written directly into its model.
+  // There is no backdoor into the LLC SPM, so chunks there always go through the serial link.
+  task automatic slink_elf_preload(input string binary, output doub_bt entry,
+                                   input bit backdoor = 0);
+    longint sec_addr, sec_len;
+    int elf, num_bursts = 0, num_backdoor = 0;
     $display("[SLINK] Preloading ELF binary: %s", binary);
-    if (read_elf(binary))
+    if (elf_open(binary, elf))
       $fatal(1, "[SLINK] Failed to load ELF!");
-    while (get_section(sec_addr, sec_len)) begin
+    // Write coalesced section data as aligned bursts, masking bytes outside sections
+    while (elf_get_chunk(elf, AxiStrbWidth, SlinkBurstBytes, SlinkMaxGapBytes, sec_addr, sec_len)) begin
       byte bf[] = new [sec_len];
-      $display("[SLINK] Preloading section at 0x%h (%0d bytes)", sec_addr, sec_len);
-      if (read_section(sec_addr, bf, sec_len)) $fatal(1, "[SLINK] Failed to read ELF section!");
-      // Write section as fixed-size bursts
-      bus_offset = sec_addr[AxiStrbBits-1:0];
-      for (longint i = 0; i <= sec_len ; i += SlinkBurstBytes) begin
-        axi_data_t beats [$];
-        if (i != 0)
-          $display("[SLINK] - %0d/%0d bytes (%0d%%)", i, sec_len, i*100/(sec_len>1 ? sec_len-1 : 1));
-        // Assemble beats for current burst from section buffer
-        for (int b = 0; b < SlinkBurstBytes; b += AxiStrbWidth) begin
-          axi_data_t beat;
-          // We handle incomplete bursts
-          if (i+b-bus_offset >= sec_len) break;
-          for (int e = 0; e < AxiStrbWidth; ++e)
-            if (i+b+e < bus_offset) begin
-              beat[8*e +: 8] = '0;
-            end else if (i+b+e-bus_offset >= sec_len) begin
-              beat[8*e +: 8] = '0;
-            end else begin
-              beat[8*e +: 8] = bf [i+b+e-bus_offset];
-            end
-
-          beats.push_back(beat);
+      byte bs[] = new [sec_len];
+      axi_data_t beats [$];
+      axi_strb_t strbs [$];
+      if (elf_read_chunk(elf, sec_addr, bf, bs, sec_len))
+        $fatal(1, "[SLINK] Failed to read ELF chunk!");
+      if (backdoor && dram_backdoor_write(sec_addr, sec_len, bf, bs)) begin
+        num_backdoor++;
+        continue;
+      end
+      if (num_bursts % 64 == 0)
+        $display("[SLINK] - Preloading burst %0d at 0x%h", num_bursts, sec_addr);
+      for (longint i = 0; i < sec_len; i += AxiStrbWidth) begin
+        axi_data_t beat;
+        axi_strb_t strb;
+        for (int e = 0; e < AxiStrbWidth; ++e) begin
+          beat[8*e +: 8] = bf[i+e];
+          strb[e] = bs[i+e][0];
         end
-        write_addr = sec_addr + (i==0 ? 0 : i - sec_addr%AxiStrbWidth);
-        // Write this burst
-        slink_write_beats(write_addr, AxiStrbBits, beats);
+        beats.push_back(beat);
+        strbs.push_back(strb);
       end
+      slink_write_beats_strb(sec_addr, AxiStrbBits, beats, strbs);
+      num_bursts++;
     end
-    void'(get_entry(entry));
+    $display("[SLINK] Wrote sections in %0d bursts and %0d backdoor chunks",
+        num_bursts, num_backdoor);
+    while (elf_get_zero_fill(elf, sec_addr, sec_len)) begin
+      $display("[SLINK] Clearing range at 0x%h (%0d bytes)", sec_addr, sec_len);
+      slink_zero_fill(sec_addr, sec_len);
+    end
+    void'(elf_get_entry(elf, entry));
+    void'(elf_close(elf));
     $display("[SLINK] Preload complete");
   endtask
 
-  // Run a binary
-  task automatic slink_elf_run(input string binary);
+  // Run a binary; see `slink_elf_preload` for `backdoor`
+  task automatic slink_elf_run(input string binary, input bit backdoor = 0);
     doub_bt entry;
     // Wait for bootrom to ungate Serial Link
     if (DutCfg.LlcNotBypass) begin
@@ -892,8 +1356,12 @@ module vip_cheshire_soc import cheshire_pkg::*; #(
       $display("[SLINK] Wait for LLC configuration");
       slink_poll_bit0(AmLlc + axi_llc_reg_pkg::AXI_LLC_CFG_SPM_LOW_OFFSET, regval, 20);
     end
-    // Preload
-    slink_elf_preload(binary, entry);
+    // Preload additional images, then binary
+    foreach (elf_extra_images[i]) begin
+      doub_bt extra_entry;
+      slink_elf_preload(elf_extra_images[i], extra_entry, backdoor);
+    end
+    slink_elf_preload(binary, entry, backdoor);
     // Write entry point
     slink_write_32(AmRegs + cheshire_reg_pkg::CHESHIRE_SCRATCH_1_OFFSET, entry[63:32]);
     slink_write_32(AmRegs + cheshire_reg_pkg::CHESHIRE_SCRATCH_0_OFFSET, entry[32:0]);
@@ -23,6 +23,7 @@ if {[info exists BOOTMODE]} { append pargs "+BOOTMODE=${BOOTMODE} " }
 if {[info exists PRELMODE]} { append pargs "+PRELMODE=${PRELMODE} " }
 if {[info exists BINARY]}   { append pargs "+BINARY=${BINARY} " }
 if {[info exists IMAGE]}    { append pargs "+IMAGE=${IMAGE} " }
+if {[info exists EXTRABINS]} { append pargs "+EXTRABINS=${EXTRABINS} " }
 
 eval "vsim -c ${TESTBENCH} -t 1ps -vopt -voptargs=\"${VOPTARGS}\"" ${pargs} ${flags}
 
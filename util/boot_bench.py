@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Reports per-stage boot latencies from the boot traces dumped by the testbench
+# (`[TRACE]` lines) in one or more simulation logs, one per boot mode.
+
+import re
+import sys
+import argparse
+
+STAGES = {
+    1: 'ROM entry',
+    2: 'ROM core frequency',
+    3: 'ROM device init',
+    4: 'ROM next stage loaded',
+    5: 'ZSL entry',
+    6: 'ZSL device tree loaded',
+    7: 'ZSL firmware loaded',
+    8: 'ZSL firmware launch',
+}
+
+TRACE_RE = re.compile(r'\[TRACE\] Stage (\d+): mcycle (\d+), mtime (\d+)')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Report boot-stage latencies')
+    parser.add_argument('LOGS', nargs='+', help='Simulation logs containing boot trace dumps')
+    parser.add_argument('--rtc-freq', type=int, default=32768, help='RTC frequency in Hz')
+    args = parser.parse_args()
+
+    for log in args.LOGS:
+        with open(log, errors='replace') as f:
+            recs = [tuple(map(int, m.groups())) for m in TRACE_RE.finditer(f.read())]
+        print(f'== {log}')
+        if not recs:
+            print('   No boot trace found')
+            continue
+        print(f'   {"Stage":<26} {"Delta cycles":>14} {"Total cycles":>14} {"Total us":>10}')
+        for i, (stage, mcycle, mtime) in enumerate(recs):
+            delta = mcycle - recs[i - 1][1] if i else 0
+            total_us = (mtime - recs[0][2]) * 1000000 // args.rtc_freq
+            name = STAGES.get(stage, f'Stage {stage}')
+            print(f'   {name:<26} {delta:>14} {mcycle - recs[0][1]:>14} {total_us:>10}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Wraps a device tree or firmware image for a ZSL-loaded partition: a header sector
+# describing the payload, followed by the payload, optionally as an LZ4 block.
+
+import sys
+import zlib
+import struct
+import argparse
+
+PART_MAGIC = b'CHSPART\0'
+PART_FLAG_LZ4 = 1 << 0
+SECTOR = 512
+
+LZ4_MIN_MATCH = 4
+LZ4_LAST_LITERALS = 5
+LZ4_MFLIMIT = 12
+
+
+def lz4_len(n: int) -> bytes:
+    """Encode the excess of a literal or match length over 15."""
+    out = bytearray()
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+    return bytes(out)
+
+
+def lz4_compress(src: bytes) -> bytes:
+    """Compress data into a single LZ4 block (greedy, hash of 4 bytes)."""
+    dst = bytearray()
+    last = {}
+    lit = i = 0
+    end = len(src)
+    while i + LZ4_MFLIMIT <= end:
+        key = src[i:i + 4]
+        ref = last.get(key)
+        last[key] = i
+        if ref is None or i - ref > 0xFFFF:
+            i += 1
+            continue
+        # Extend match, keeping the last literals out of it
+        mlen = 4
+        while i + mlen < end - LZ4_LAST_LITERALS and src[ref + mlen] == src[i + mlen]:
+            mlen += 1
+        nlit = i - lit
+        mcode = mlen - LZ4_MIN_MATCH
+        dst.append((min(nlit, 15) << 4) | min(mcode, 15))
+        if nlit >= 15:
+            dst += lz4_len(nlit - 15)
+        dst += src[lit:i]
+        dst += struct.pack('<H', i - ref)
+        if mcode >= 15:
+            dst += lz4_len(mcode - 15)
+        i += mlen
+        lit = i
+    # Last sequence holds only literals
+    nlit = end - lit
+    dst.append(min(nlit, 15) << 4)
+    if nlit >= 15:
+        dst += lz4_len(nlit - 15)
+    dst += src[lit:]
+    return bytes(dst)
+
+
+def lz4_decompress(src: bytes) -> bytes:
+    """Reference LZ4 block decoder matching the ZSL's."""
+    out = bytearray()
+    i = 0
+    while True:
+        tok = src[i]
+        i += 1
+        nlit = tok >> 4
+        if nlit == 15:
+            while True:
+                nlit += src[i]
+                i += 1
+                if src[i - 1] != 255:
+                    break
+        out += src[i:i + nlit]
+        i += nlit
+        if i == len(src):
+            return bytes(out)
+        off = src[i] | (src[i + 1] << 8)
+        i += 2
+        mlen = tok & 15
+        if mlen == 15:
+            while True:
+                mlen += src[i]
+                i += 1
+                if src[i - 1] != 255:
+                    break
+        for _ in range(mlen + LZ4_MIN_MATCH):
+            out.append(out[-off])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate a ZSL partition image')
+    parser.add_argument('INPUT', help='Raw device tree or firmware image')
+    parser.add_argument('OUTPUT', help='Partition image to write')
+    parser.add_argument('--lz4', action='store_true', help='Compress payload as an LZ4 block')
+    args = parser.parse_args()
+
+    with open(args.INPUT, 'rb') as f:
+        data = f.read()
+    flags = 0
+    payload = data
+    if args.lz4:
+        comp = lz4_compress(data)
+        assert lz4_decompress(comp) == data, 'LZ4 round trip failed'
+        # Only keep compression if it saves at least one sector
+        if len(comp) + SECTOR <= len(data):
+            flags |= PART_FLAG_LZ4
+            payload = comp
+    hdr = PART_MAGIC + struct.pack('<QQQQ', flags, len(payload), len(data), zlib.crc32(payload))
+    with open(args.OUTPUT, 'wb') as f:
+        f.write(hdr.ljust(SECTOR, b'\0'))
+        f.write(payload)
+    print(f'{args.INPUT}: {len(data)} -> {len(payload)} bytes', file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Host-side loader for the boot ROM's UART debug server: preloads the loadable
+# segments of an ELF binary, then executes it and reports its return code.
+
+import sys
+import time
+import zlib
+import struct
+import argparse
+
+# UART debug opcodes
+CMD_READ = 0x11
+CMD_WRITE = 0x12
+CMD_EXEC = 0x13
+CMD_WRITE_LZ = 0x15
+CMD_WRITE_WIN = 0x16
+CMD_SET_BAUD = 0x17
+ACK = 0x06
+NAK = 0x18
+SOH = 0x01
+EOT = 0x04
+EOC = 0x14
+
+
+def lz_compress(src: bytes) -> bytes:
+    """Compress data into the token format of the WRITELZ command."""
+    dst = bytearray()
+    last = {}
+    lit = i = 0
+    while i <= len(src):
+        mlen = off = 0
+        if i + 3 <= len(src):
+            key = src[i:i + 3]
+            if key in last and i - last[key] < 0x10000:
+                off = i - last[key]
+                while mlen < 130 and i + mlen < len(src) and src[i + mlen - off] == src[i + mlen]:
+                    mlen += 1
+            last[key] = i
+        # Emit pending literals before a match or at the end
+        if mlen >= 3 or i == len(src):
+            for l in range(lit, i, 128):
+                num = min(i - l, 128)
+                dst.append(num - 1)
+                dst += src[l:l + num]
+        if i == len(src):
+            break
+        if mlen >= 3:
+            dst += bytes([0x80 | (mlen - 3), off & 0xFF, off >> 8])
+            i += mlen
+            lit = i
+        else:
+            i += 1
+    return bytes(dst)
+
+
+def lz_decompress(src: bytes) -> bytes:
+    """Reference decoder matching the debug server's."""
+    out = bytearray()
+    i = 0
+    while i < len(src):
+        tok = src[i]
+        i += 1
+        if tok < 0x80:
+            out += src[i:i + tok + 1]
+            i += tok + 1
+        else:
+            off = src[i] | (src[i + 1] << 8)
+            i += 2
+            for _ in range((tok & 0x7F) + 3):
+                out.append(out[-off])
+    return bytes(out)
+
+
+def elf_segments(path):
+    """Yield (paddr, data, memsz) for all loadable segments of an ELF64 LE file."""
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF' or elf[4] != 2 or elf[5] != 1:
+        raise ValueError(f'{path} is not a little-endian ELF64 file')
+    entry, phoff = struct.unpack_from('<QQ', elf, 0x18)
+    phentsize, phnum = struct.unpack_from('<HH', elf, 0x36)
+    segs = []
+    for p in range(phnum):
+        ptype, _, offs, _, paddr, filesz, memsz, _ = struct.unpack_from(
+            '<IIQQQQQQ', elf, phoff + p * phentsize)
+        if ptype == 1 and memsz != 0:
+            segs.append((paddr, elf[offs:offs + filesz], memsz))
+    return entry, segs
+
+
+class UartDebug:
+
+    def __init__(self, port, baud, block, compress, frame, window):
+        import serial
+        self.ser = serial.Serial(port, baud, timeout=10)
+        self.block = block
+        self.compress = compress
+        self.frame = frame
+        self.window = window
+
+    def expect(self, name, code):
+        got = self.ser.read(1)
+        if got != bytes([code]):
+            raise IOError(f'Expected {name}, got {got!r}')
+
+    def connect(self):
+        self.ser.reset_input_buffer()
+        self.ser.write(bytes([ACK]))
+        self.expect('ACK', ACK)
+
+    def set_baud(self, baud):
+        """Switch the server and us to a new baud rate; returns whether this succeeded."""
+        old_baud = self.ser.baudrate
+        self.ser.write(bytes([CMD_SET_BAUD]) + struct.pack('<Q', baud))
+        if self.ser.read(1) != bytes([ACK]):
+            return False
+        # Give the server time to reconfigure, then confirm the new rate
+        self.ser.flush()
+        time.sleep(0.01)
+        self.ser.baudrate = baud
+        self.ser.reset_input_buffer()
+        self.ser.write(bytes([ACK]))
+        if self.ser.read(1) == bytes([ACK]):
+            return True
+        # The server reverts and sends NAK at the old rate
+        self.ser.baudrate = old_baud
+        self.ser.read(1)
+        return False
+
+    def write_win(self, addr, data):
+        """Stream CRC-checked frames, rewinding on NAK or when acknowledges stall."""
+        num = (len(data) + self.frame - 1) // self.frame
+        self.ser.write(bytes([CMD_WRITE_WIN]) + struct.pack('<QQQ', addr, len(data), self.frame))
+        self.expect('ACK', ACK)
+        base = nxt = 0
+        rx = bytearray()
+        last_progress = time.monotonic()
+        stall = 2 * (self.window + 1) * (self.frame + 9) * 10 / self.ser.baudrate + 0.5
+        self.ser.timeout = 0.05
+        while base < num:
+            if nxt < num and nxt < base + self.window:
+                payload = struct.pack('<I', nxt) + data[nxt * self.frame:(nxt + 1) * self.frame]
+                self.ser.write(bytes([SOH]) + payload + struct.pack('<I', zlib.crc32(payload)))
+                nxt += 1
+                if not self.ser.in_waiting:
+                    continue
+            # Process replies (ACK or NAK with a 32-bit frame index)
+            rx += self.ser.read(max(1, self.ser.in_waiting))
+            while len(rx) >= 5:
+                code, idx = struct.unpack_from('<BI', rx)
+                del rx[:5]
+                if code == NAK:
+                    nxt = idx
+                elif code != ACK:
+                    raise IOError(f'Expected ACK or NAK, got {code:#x}')
+                if idx > base:
+                    base = idx
+                    last_progress = time.monotonic()
+            # Rewind if acknowledges stall, e.g. because a frame was lost entirely
+            if time.monotonic() - last_progress > stall:
+                nxt = base
+                last_progress = time.monotonic()
+        self.ser.timeout = 10
+
+    def write(self, addr, data):
+        lz = lz_compress(data) if self.compress else None
+        if lz is not None:
+            assert lz_decompress(lz) == data, 'LZ round trip failed'
+        if lz is not None and len(lz) + 8 < len(data):
+            self.ser.write(bytes([CMD_WRITE_LZ]) + struct.pack('<QQQ', addr, len(data), len(lz)))
+            self.expect('ACK', ACK)
+            self.ser.write(lz)
+        elif self.window:
+            self.write_win(addr, data)
+        else:
+            self.ser.write(bytes([CMD_WRITE]) + struct.pack('<QQ', addr, len(data)))
+            self.expect('ACK', ACK)
+            self.ser.write(data)
+        self.expect('EOT', EOT)
+
+    def load(self, addr, data):
+        for i in range(0, len(data), self.block):
+            self.write(addr + i, data[i:i + self.block])
+
+    def execute(self, addr, boot_baud):
+        self.ser.write(bytes([CMD_EXEC]) + struct.pack('<Q', addr))
+        # The server returns to the boot baud rate on EXEC
+        self.ser.flush()
+        self.ser.baudrate = boot_baud
+        self.expect('ACK', ACK)
+        # Forward program output until EOC, then receive return code
+        self.ser.timeout = None
+        while (c := self.ser.read(1)) != bytes([EOC]):
+            sys.stdout.buffer.write(c)
+            sys.stdout.flush()
+        return struct.unpack('<I', self.ser.read(4))[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Preload and run an ELF through UART debug')
+    parser.add_argument('BINARY', help='ELF binary to preload and run')
+    parser.add_argument('--port', '-p', default='/dev/ttyUSB0', help='Serial port')
+    parser.add_argument('--baud', '-b', type=int, default=115200, help='Boot baud rate')
+    parser.add_argument('--fast-baud',
+                        default='3000000,2000000,1500000,1000000,921600,460800,230400',
+                        help='Comma-separated baud rates to try for preloading (empty: none)')
+    parser.add_argument('--block', type=int, default=4096, help='Bytes per write command')
+    parser.add_argument('--no-compress', action='store_true', help='Never use compressed writes')
+    parser.add_argument('--frame', type=int, default=256, help='Bytes per windowed write frame')
+    parser.add_argument('--window',
+                        type=int,
+                        default=8,
+                        help='Frames in flight for windowed writes (0: use raw writes)')
+    parser.add_argument('--no-exec', action='store_true', help='Only preload the binary')
+    args = parser.parse_args()
+
+    entry, segs = elf_segments(args.BINARY)
+    dbg = UartDebug(args.port, args.baud, args.block, not args.no_compress, args.frame,
+                    args.window)
+    dbg.connect()
+    for baud in (int(b) for b in args.fast_baud.split(',') if b):
+        if dbg.set_baud(baud):
+            print(f'Switched to {baud} baud', file=sys.stderr)
+            break
+    for paddr, data, memsz in segs:
+        print(f'Loading {memsz} bytes to 0x{paddr:x}', file=sys.stderr)
+        dbg.load(paddr, data + bytes(memsz - len(data)))
+    if args.no_exec:
+        return 0
+    print(f'Executing from 0x{entry:x}', file=sys.stderr)
+    ret = dbg.execute(entry, args.baud)
+    print(f'Returned {ret}', file=sys.stderr)
+    return 1 if ret else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
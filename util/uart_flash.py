@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Host-side counterpart to `sw/tests/spi_s25fs512s_flash.c`: sends a GPT disk image
+# to the running flash driver, which reflashes it to NOR flash sector by sector.
+
+import sys
+import struct
+import argparse
+
+# Same ACK, NAK, and EOT codes as the UART debug protocol (`sw/lib/hal/uart_debug.c`)
+ACK = 0x06
+NAK = 0x18
+EOT = 0x04
+
+SECTOR_SIZE = 256 * 1024
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Reflash a NOR disk image over UART')
+    parser.add_argument('IMAGE', help='GPT disk image to flash')
+    parser.add_argument('--port', '-p', default='/dev/ttyUSB0', help='Serial port')
+    parser.add_argument('--baud', '-b', type=int, default=115200, help='Baud rate')
+    args = parser.parse_args()
+
+    import serial
+    with open(args.IMAGE, 'rb') as f:
+        image = f.read()
+    ser = serial.Serial(args.port, args.baud, timeout=None)
+
+    def expect_ack(what):
+        got = ser.read(1)
+        if got == bytes([NAK]):
+            code = struct.unpack('<I', ser.read(4))[0]
+            raise IOError(f'Driver failed {what} with error 0x{code:x}')
+        if got != bytes([ACK]):
+            raise IOError(f'Expected ACK after {what}, got {got!r}')
+
+    ser.write(struct.pack('<Q', len(image)))
+    expect_ack('length')
+    for offs in range(0, len(image), SECTOR_SIZE):
+        ser.write(image[offs:offs + SECTOR_SIZE])
+        expect_ack(f'sector at 0x{offs:x}')
+        print(f'Flashed {min(offs + SECTOR_SIZE, len(image))}/{len(image)} bytes',
+              file=sys.stderr)
+    got = ser.read(1)
+    if got != bytes([EOT]):
+        raise IOError(f'Flashed image failed verification ({got!r})')
+    print(ser.readline().decode(errors='replace').strip(), file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())